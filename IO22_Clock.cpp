@@ -0,0 +1,69 @@
+/*
+  cycle counter for the IO22D08 library
+
+  - Timer1 runs free in normal mode at clk/1; the overflow ISR (in the
+    sketch, see IO22_CLOCK_ISRS()) extends the 16-bit count to 32 bits
+  - reading the extended count has to cope with an overflow that has
+    happened, but has not yet been serviced (e.g. when called from another
+    ISR, or in the few cycles before the overflow ISR gets to run): if the
+    overflow flag is pending and the count has only just wrapped (is in the
+    lower half) then the overflow belongs to this reading
+*/
+
+#include "Arduino.h"
+#include "IO22_Clock.h"
+
+volatile uint16_t IO22Clock::_overflows = 0;
+bool IO22Clock::_running = false;
+
+#ifdef IO22D08_AVR_M328
+
+// - without the vector (IO22_CLOCK_ISRS()) the overflow interrupt enabled
+//   below would reset the board: fail instead
+bool IO22Clock::begin()
+{
+  if (_running) return true;
+  if (!_vectors) return false;
+  IO22InterruptLock lock;
+  TCCR1A = 0;                 // normal mode
+  TCCR1B = _BV(CS10);         // clk/1
+  TCNT1 = 0;
+  TIFR1 = _BV(TOV1);
+  TIMSK1 |= _BV(TOIE1);
+  _running = true;
+  return true;
+}
+
+uint32_t IO22Clock::nowFromISR()
+{
+  uint16_t t = TCNT1;
+  uint16_t ovf = _overflows;
+  if ((TIFR1 & _BV(TOV1)) && t < 0x8000) ovf++;
+  return ((uint32_t)ovf << 16) | t;
+}
+
+uint32_t IO22Clock::now()
+{
+  IO22InterruptLock lock;
+  return nowFromISR();
+}
+
+#else
+
+bool IO22Clock::begin()
+{
+  _running = true;
+  return true;
+}
+
+uint32_t IO22Clock::nowFromISR()
+{
+  return micros() * cyclesPerMicrosecond;
+}
+
+uint32_t IO22Clock::now()
+{
+  return nowFromISR();
+}
+
+#endif
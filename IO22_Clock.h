@@ -0,0 +1,59 @@
+#ifndef IO22_Clock_h
+
+#define IO22_Clock_h
+
+#include "Arduino.h"
+#include "IO22_Platform.h"
+
+// a free-running cycle counter: Timer1 at clk/1 (62.5ns at 16MHz), extended
+// to 32 bits by counting overflows (every 4.096ms)
+// - 32 bits of cycles rolls over every ~268s; use differences, as for millis()
+// - takes over Timer1: no PWM on pins 9/10 (fine, they're buttons K3/K4 on
+//   the IO22D08) and not compatible with the Servo library
+// - the Timer1 overflow vector is opt-in, so sketches that don't use the
+//   clock keep Timer1 for TimerOne, Servo, etc.: expand IO22_CLOCK_ISRS()
+//   once in a sketch that uses it (directly, or via IO22FrequencyInput,
+//   IO22ModbusRTU or IO22_PROFILE); begin() fails without it
+// - ATmega328P only; elsewhere the clock is built on micros()
+class IO22Clock
+{
+  public:
+    static const uint8_t cyclesPerMicrosecond = F_CPU / 1000000UL;
+
+    // idempotent; every user of the clock calls it
+    // - false (and Timer1 left alone) without IO22_CLOCK_ISRS()
+    static bool begin();
+    static bool isRunning() { return _running; }
+
+    // current time in cycles
+    static uint32_t now();
+    // as now(), for callers that already have interrupts disabled (ISRs)
+    static uint32_t nowFromISR();
+
+    static uint32_t cyclesToMicros(uint32_t c) { return c / cyclesPerMicrosecond; }
+    static uint32_t microsToCycles(uint32_t us) { return us * cyclesPerMicrosecond; }
+
+    // Timer1 overflow ISR hook; not for use by sketches
+    // - _vectors(): defined by IO22_CLOCK_ISRS(), i.e. null unless the sketch
+    //   has the vector
+    static void _vectors() __attribute__((weak));
+    static void _isrOverflow() { _overflows++; }
+
+  protected:
+    static volatile uint16_t _overflows;
+    static bool _running;
+};
+
+// the vector (see above); at file scope, in the one sketch using the clock
+#ifdef IO22D08_AVR_M328
+#define IO22_CLOCK_ISRS() \
+  ISR(TIMER1_OVF_vect) \
+  { \
+    IO22Clock::_isrOverflow(); \
+  } \
+  void IO22Clock::_vectors() {}
+#else
+#define IO22_CLOCK_ISRS()
+#endif
+
+#endif
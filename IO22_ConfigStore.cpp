@@ -0,0 +1,148 @@
+/*
+  wear-levelled EEPROM config store for the IO22 boards
+
+  - slot layout: header (sequence, version, size), block, CRC-16 (over the
+    header and block); sequence numbers are compared as (signed) differences
+    so they can wrap
+  - save() writes the block and CRC before the header: until the header is
+    complete the slot either still has its old header (whose CRC no longer
+    matches) or a torn one, so load() never takes a half-written slot
+  - a newest slot that fails its CRC is passed over for the next newest
+*/
+
+#include "Arduino.h"
+#include "IO22_ConfigStore.h"
+
+#ifdef __AVR__
+#include <avr/eeprom.h>
+
+bool IO22ConfigStore::_readSlot(uint8_t slot, void *data, uint8_t size, const Header &header)
+{
+  uint16_t address = _slotAddress(slot, size);
+  uint16_t stored;
+  eeprom_read_block(data, (const void *)(uintptr_t)(address + sizeof(Header)), size);
+  eeprom_read_block(&stored, (const void *)(uintptr_t)(address + sizeof(Header) + size), sizeof(stored));
+  uint16_t crc = IO22Crc16::update(IO22Crc16::initial, &header, sizeof(Header));
+  return IO22Crc16::update(crc, data, size) == stored;
+}
+
+bool IO22ConfigStore::load(void *data, uint8_t size, uint8_t version)
+{
+  Header headers[16];
+  for (uint8_t s = 0; s < _slots; s++)
+    eeprom_read_block(&headers[s], (const void *)(uintptr_t)_slotAddress(s, size), sizeof(Header));
+  uint16_t tried = 0;
+  for (;;)
+  {
+    int8_t newest = -1;
+    for (uint8_t s = 0; s < _slots; s++)
+    {
+      if ((tried & _BV(s)) || headers[s].version != version || headers[s].size != size) continue;
+      if (newest < 0 || (int16_t)(headers[s].sequence - headers[newest].sequence) > 0) newest = s;
+    }
+    if (newest < 0) return false;
+    tried |= _BV(newest);
+    if (_readSlot(newest, data, size, headers[newest]))
+    {
+      _current = newest;
+      _sequence = headers[newest].sequence;
+      return true;
+    }
+  }
+}
+
+bool IO22ConfigStore::save(const void *data, uint8_t size, uint8_t version)
+{
+  uint8_t slot = _current < 0 ? 0 : (_current + 1) % _slots;
+  Header header = {(uint16_t)(_sequence + 1), version, size};
+  uint16_t crc = IO22Crc16::update(IO22Crc16::initial, &header, sizeof(Header));
+  crc = IO22Crc16::update(crc, data, size);
+  uint16_t address = _slotAddress(slot, size);
+  eeprom_update_block(data, (void *)(uintptr_t)(address + sizeof(Header)), size);
+  eeprom_update_block(&crc, (void *)(uintptr_t)(address + sizeof(Header) + size), sizeof(crc));
+  eeprom_update_block(&header, (void *)(uintptr_t)address, sizeof(Header));
+  _current = slot;
+  _sequence = header.sequence;
+  return true;
+}
+
+uint8_t IO22RelayRetain::load()
+{
+  _loaded = true;
+  _count = 0xFF;
+  _relays = 0;
+  const uint8_t *p = (const uint8_t *)(uintptr_t)_address;
+  uint8_t first = eeprom_read_byte(p + 1);
+  uint8_t count = first;
+  for (uint8_t e = 0; e < _entries; e++)
+  {
+    // the entry after this one (which for the last is the first, read above)
+    uint8_t next = e + 1 < _entries ? eeprom_read_byte(p + 2 * (e + 1) + 1) : first;
+    if (count != 0xFF && next != _nextCount(count))
+    {
+      _newest = e;
+      _count = count;
+      _relays = eeprom_read_byte(p + 2 * e);
+      break;
+    }
+    count = next;
+  }
+  return _relays;
+}
+
+void IO22RelayRetain::update(uint8_t relays)
+{
+  if (!_loaded) load();
+  if (_count != 0xFF && relays == _relays) return;
+  uint8_t e = _count == 0xFF ? 0 : (_newest + 1) % _entries;
+  uint8_t *p = (uint8_t *)(uintptr_t)(_address + 2 * e);
+  _count = _nextCount(_count);
+  eeprom_update_byte(p, relays);
+  eeprom_update_byte(p + 1, _count);
+  _newest = e;
+  _relays = relays;
+}
+
+#else
+
+uint8_t IO22RelayRetain::load()
+{
+  return 0;
+}
+
+void IO22RelayRetain::update(uint8_t relays)
+{
+  _relays = relays;
+}
+
+bool IO22ConfigStore::_readSlot(uint8_t, void *, uint8_t, const Header &)
+{
+  return false;
+}
+
+bool IO22ConfigStore::load(void *, uint8_t, uint8_t)
+{
+  return false;
+}
+
+bool IO22ConfigStore::save(const void *, uint8_t, uint8_t)
+{
+  return false;
+}
+
+#endif
+
+void IO22Config::applyTimers(IO22RelayTimers &relayTimers) const
+{
+  for (uint8_t id = 0; id < IO22RelayTimers::maxTimers; id++)
+    relayTimers.setTimeout(id, timers[id].relayMask, timers[id].seconds);
+}
+
+void IO22Config::readTimers(IO22RelayTimers &relayTimers)
+{
+  for (uint8_t id = 0; id < IO22RelayTimers::maxTimers; id++)
+  {
+    timers[id].relayMask = relayTimers.relayMask(id);
+    timers[id].seconds = relayTimers.timeout(id);
+  }
+}
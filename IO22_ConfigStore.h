@@ -0,0 +1,126 @@
+#ifndef IO22_ConfigStore_h
+
+#define IO22_ConfigStore_h
+
+#include "Arduino.h"
+#include "IO22_RelayTimers.h"
+
+// persistent settings in EEPROM: a small binary block, versioned and CRC
+// checked, rotated through a number of slots to spread the wear
+// - each slot holds a header (sequence number, version, size), the block and
+//   a CRC-16 over both; load() picks the valid slot with the newest sequence
+//   number (by reading only the headers), then reads that slot in one go
+// - save() writes the next slot round with the next sequence number: N slots
+//   = N times the EEPROM's endurance (100k writes per cell on the ATmega328P)
+// - the header is written last, and a slot only counts once its CRC checks
+//   out: a save cut short by a power failure leaves the previous copy in
+//   place
+// - the version is the block layout's: a block saved with another version
+//   (or size) is ignored, i.e. load() fails and the sketch falls back to its
+//   defaults
+// - save() blocks for the EEPROM writes, ~3.4ms per byte that differs from
+//   what the slot held before (unchanged bytes aren't rewritten); load() is
+//   a few us: fine for the boot path
+// - AVR only (avr/eeprom.h); elsewhere load() fails and save() does nothing
+class IO22ConfigStore
+{
+  public:
+    static const uint8_t defaultSlots = 8;
+
+    // address: the first EEPROM byte used; slots: copies to rotate through
+    // (at most 16); the store takes slots x slotSize(size) bytes
+    IO22ConfigStore(uint16_t address = 0, uint8_t slots = defaultSlots) :
+      _address(address), _slots(slots > 16 ? 16 : slots) {}
+
+    // the newest valid copy of the size byte block saved with version, into
+    // data; false if there isn't one (first boot, another layout): data is
+    // then undefined, load the defaults
+    // - version: 0-254 (255 is erased EEPROM)
+    bool load(void *data, uint8_t size, uint8_t version);
+    bool save(const void *data, uint8_t size, uint8_t version);
+    // for a struct with a static version member, e.g. IO22Config
+    template <class T> bool load(T &data) { return load(&data, sizeof(T), T::version); }
+    template <class T> bool save(const T &data) { return save(&data, sizeof(T), T::version); }
+
+    // sequence number of the copy last loaded/saved, 0 if none yet
+    uint16_t sequence() { return _sequence; }
+    static uint16_t slotSize(uint8_t size) { return sizeof(Header) + size + 2; }
+
+  protected:
+    struct Header
+    {
+      uint16_t sequence;
+      uint8_t version;
+      uint8_t size;
+    };
+
+    uint16_t _address;
+    uint8_t _slots;
+    int8_t _current = -1;   // slot last loaded/saved
+    uint16_t _sequence = 0;
+
+    uint16_t _slotAddress(uint8_t slot, uint8_t size) { return _address + slot * slotSize(size); }
+    bool _readSlot(uint8_t slot, void *data, uint8_t size, const Header &header);
+};
+
+// the relay state across power cycles, e.g. for
+// IO22Board::begin(STARTUP_INSTANT_ON, relayRetain.load())
+// - a ring of 2 byte entries (relays, count) in EEPROM: update() writes the
+//   next entry round only when the state has changed, 2 bytes (~7ms,
+//   blocking); N entries = N times the endurance, e.g. 32 entries and a relay
+//   change a minute last ~6 years
+// - the count steps by one per entry (skipping 0xFF, erased EEPROM); the
+//   newest entry is the one the next entry doesn't follow on from, and the
+//   count is written after the relay byte, so a write cut short leaves the
+//   previous entry the newest
+// - keep it clear of an IO22ConfigStore's slots
+// - AVR only; elsewhere load() returns 0
+class IO22RelayRetain
+{
+  public:
+    static const uint8_t defaultEntries = 32;
+
+    // address: the first EEPROM byte used; entries: 2-254, the ring takes
+    // 2 x entries bytes
+    IO22RelayRetain(uint16_t address, uint8_t entries = defaultEntries) :
+      _address(address), _entries(entries < 2 ? 2 : entries > 254 ? 254 : entries) {}
+
+    // the last state saved; 0 (all off) if none
+    uint8_t load();
+    // save the state if it differs from the last one saved
+    void update(uint8_t relays);
+
+  protected:
+    uint16_t _address;
+    uint8_t _entries;
+    uint8_t _newest = 0;
+    uint8_t _count = 0xFF;  // the newest entry's, 0xFF = no entries
+    uint8_t _relays = 0;
+    bool _loaded = false;
+
+    static uint8_t _nextCount(uint8_t c) { return c >= 0xFE ? 0 : c + 1; }
+};
+
+// the library's settings: relay timers and frequency switch thresholds, plus
+// the display brightness
+// - fill in the defaults when load() fails, then apply
+struct IO22Config
+{
+  static const uint8_t version = 1;
+
+  struct Timer
+  {
+    uint8_t relayMask;
+    uint16_t seconds;
+  };
+  Timer timers[IO22RelayTimers::maxTimers];
+  // stopped, lower, upper: periods (us), as for IO22FrequencyInput::setThresholds()
+  uint32_t frequencyThresholds[3];
+  uint8_t brightness;
+
+  // timer settings to/from a set of relay timers
+  void applyTimers(IO22RelayTimers &relayTimers) const;
+  void readTimers(IO22RelayTimers &relayTimers);
+};
+
+#endif
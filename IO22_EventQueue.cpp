@@ -0,0 +1,66 @@
+/*
+  event queue for the IO22D08
+
+  - single consumer ring buffer: the consumer only ever writes _tail, and
+    only after it has copied the event out; the producers only ever write
+    _head, and only after the event has been filled in; both are bytes, so
+    each side sees either the old or the new index, never a torn one
+  - the consumer's copy has to happen after it has read _head and be
+    complete before _tail releases the slot: compiler barriers keep the
+    (non-volatile) copy between the two
+  - (head - tail) is the number of queued events, uint8_t arithmetic takes
+    care of the wrap
+*/
+
+#include "Arduino.h"
+#include "IO22_EventQueue.h"
+
+bool IO22EventQueue::push(uint8_t type, uint8_t id, uint8_t value)
+{
+  uint32_t now = micros();
+  IO22InterruptLock lock;
+  uint8_t h = _head;
+  if ((uint8_t)(h - _tail) >= capacity)
+  {
+    if (_dropped < 0xFF) _dropped++;
+    return false;
+  }
+  IO22Event &e = _events[h & _mask];
+  e.time = now;
+  e.type = type;
+  e.id = id;
+  e.value = value;
+  _head = h + 1;
+  return true;
+}
+
+bool IO22EventQueue::pop(IO22Event &event)
+{
+  uint8_t t = _tail;
+  if (t == _head) return false;
+  __asm__ __volatile__("" ::: "memory");
+  event = _events[t & _mask];
+  __asm__ __volatile__("" ::: "memory");
+  _tail = t + 1;
+  return true;
+}
+
+uint8_t IO22EventQueue::drain(IO22Event *events, uint8_t max)
+{
+  uint8_t t = _tail;
+  uint8_t n = _head - t;
+  if (n > max) n = max;
+  __asm__ __volatile__("" ::: "memory");
+  for (uint8_t i = 0; i < n; i++) events[i] = _events[(uint8_t)(t + i) & _mask];
+  __asm__ __volatile__("" ::: "memory");
+  _tail = t + n;
+  return n;
+}
+
+uint8_t IO22EventQueue::takeDropped()
+{
+  IO22InterruptLock lock;
+  uint8_t d = _dropped;
+  _dropped = 0;
+  return d;
+}
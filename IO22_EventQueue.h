@@ -0,0 +1,66 @@
+#ifndef IO22_EventQueue_h
+
+#define IO22_EventQueue_h
+
+#include "Arduino.h"
+#include "IO22_IO_Board.h"
+
+// a timestamped board event
+// - input/button: id = IN1-IN8/K1-K4 (1-based), value = 1 active/pressed,
+//   0 released
+// - relay: id = R1-R8, value = 1 on, 0 off
+// - frequency: id = IN1/IN2, value = IO22FrequencyInput::FSState
+struct IO22Event
+{
+  uint32_t time;                        // micros() when pushed
+  uint8_t type;
+  uint8_t id;
+  uint8_t value;
+};
+
+class IO22EventQueue
+{
+  // a fixed size ring buffer of board events: pushed where they happen (ISRs
+  // or loop()), drained by loop() in batches whenever it gets around to it
+  // - the producers never block: when the queue is full the event is dropped
+  //   and counted
+  // - the consumer (pop()/drain()) is lock-free; it must only be called from
+  //   one context (i.e. loop())
+  // - the producers are ISRs and loop() alike (e.g. relaySet() is called from
+  //   both), so push() takes a short interrupt lock around claiming the slot
+  //   rather than relying on there being a single producer
+  // - the indices are free-running bytes, masked on use: capacity has to be a
+  //   power of two (that divides 256)
+  // - SRAM footprint: 7 bytes per event + 4
+
+  public:
+    static const uint8_t capacity = 16;
+
+    static const uint8_t EVENT_INPUT = 0;
+    static const uint8_t EVENT_BUTTON = 1;
+    static const uint8_t EVENT_RELAY = 2;
+    static const uint8_t EVENT_FREQUENCY = 3;
+
+    // false if the queue is full (the event's dropped)
+    bool push(uint8_t type, uint8_t id, uint8_t value);
+
+    bool pop(IO22Event &event);
+    // pop up to max events into events[], returns the number popped
+    uint8_t drain(IO22Event *events, uint8_t max);
+
+    uint8_t available() { return (uint8_t)(_head - _tail); }
+    bool isEmpty() { return _head == _tail; }
+    // events dropped (queue full) since the last call
+    uint8_t takeDropped();
+
+  protected:
+    static const uint8_t _mask = capacity - 1;
+    static_assert((capacity & _mask) == 0, "IO22EventQueue capacity must be a power of two");
+
+    IO22Event _events[capacity];
+    volatile uint8_t _head = 0;         // next slot to push (producers)
+    volatile uint8_t _tail = 0;         // next slot to pop (consumer)
+    volatile uint8_t _dropped = 0;
+};
+
+#endif
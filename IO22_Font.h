@@ -0,0 +1,65 @@
+#ifndef IO22_Font_h
+
+#define IO22_Font_h
+
+#include "Arduino.h"
+
+// 7-segment glyphs, built at compile time
+// - a glyph is described by its segments, one bit each in the order
+//   DP a b c d e f g (bit 7 = DP ... bit 0 = g; the MAX7219 order used in
+//   display.md), e.g. '3' = a, b, c, d, g = 0b01111001
+// - IO22Glyph() turns that into a board's shift register word: each lit
+//   segment's (logic level) bit ORed in, then inverted to active low by the
+//   segment mask; the boards' traits wrap it with their wiring
+//   (IO22D08Traits::glyph() etc.), so the tables are constants in flash and
+//   there's no runtime conversion
+constexpr uint16_t IO22Glyph(uint8_t segments, uint16_t segmentMask,
+  uint16_t a, uint16_t b, uint16_t c, uint16_t d, uint16_t e, uint16_t f, uint16_t g, uint16_t dp)
+{
+  return segmentMask ^ (
+    ((segments & 0x80) ? dp : 0) |
+    ((segments & 0x40) ? a : 0) |
+    ((segments & 0x20) ? b : 0) |
+    ((segments & 0x10) ? c : 0) |
+    ((segments & 0x08) ? d : 0) |
+    ((segments & 0x04) ? e : 0) |
+    ((segments & 0x02) ? f : 0) |
+    ((segments & 0x01) ? g : 0));
+}
+
+// the printable ASCII font: ' ' (0x20) .. DEL (0x7F), 96 characters
+// - IO22_FONT_ASCII(G) expands to the list of segment patterns wrapped in G,
+//   e.g. G = IO22D08Traits::glyph to build that board's font table
+// - letters are upper or lower case as best suits 7 segments, e.g. 'A' and 'a'
+//   are both shown as "A", 'b' and 'B' as "b"; M, W, K, X, V are at best rough
+//   approximations and '.' is blank (no per-digit DPs on these displays)
+static const uint8_t IO22FontFirst = ' ';
+static const uint8_t IO22FontSize = 96;
+
+#define IO22_FONT_ASCII(G) \
+  G(0x00), G(0x30), G(0x22), G(0x37),  /* ' ' ! " # */ \
+  G(0x5B), G(0x12), G(0x7D), G(0x20),  /* $ % & ' */ \
+  G(0x4E), G(0x78), G(0x63), G(0x31),  /* ( ) * + */ \
+  G(0x04), G(0x01), G(0x00), G(0x25),  /* , - . / */ \
+  G(0x7E), G(0x30), G(0x6D), G(0x79),  /* 0 1 2 3 */ \
+  G(0x33), G(0x5B), G(0x5F), G(0x70),  /* 4 5 6 7 */ \
+  G(0x7F), G(0x7B), G(0x48), G(0x28),  /* 8 9 : ; */ \
+  G(0x0B), G(0x09), G(0x29), G(0x65),  /* < = > ? */ \
+  G(0x7D), G(0x77), G(0x1F), G(0x4E),  /* @ A B C */ \
+  G(0x3D), G(0x4F), G(0x47), G(0x5E),  /* D E F G */ \
+  G(0x37), G(0x06), G(0x3C), G(0x57),  /* H I J K */ \
+  G(0x0E), G(0x54), G(0x76), G(0x7E),  /* L M N O */ \
+  G(0x67), G(0x73), G(0x46), G(0x5B),  /* P Q R S */ \
+  G(0x0F), G(0x3E), G(0x3E), G(0x2A),  /* T U V W */ \
+  G(0x37), G(0x3B), G(0x6D), G(0x4E),  /* X Y Z [ */ \
+  G(0x13), G(0x78), G(0x62), G(0x08),  /* \ ] ^ _ */ \
+  G(0x02), G(0x7D), G(0x1F), G(0x0D),  /* ` a b c */ \
+  G(0x3D), G(0x6F), G(0x47), G(0x7B),  /* d e f g */ \
+  G(0x17), G(0x10), G(0x38), G(0x57),  /* h i j k */ \
+  G(0x06), G(0x54), G(0x15), G(0x1D),  /* l m n o */ \
+  G(0x67), G(0x73), G(0x05), G(0x5B),  /* p q r s */ \
+  G(0x0F), G(0x1C), G(0x1C), G(0x2A),  /* t u v w */ \
+  G(0x37), G(0x3B), G(0x6D), G(0x4E),  /* x y z { */ \
+  G(0x06), G(0x78), G(0x40), G(0x00)   /* | } ~ DEL */
+
+#endif
@@ -0,0 +1,171 @@
+/*
+  frequency input for IN1/IN2
+
+  - can measure frequency either by
+     1) counting the number of pulses in a given period
+       - requires longer sample periods as the frequency decreases (or
+         conversely loses resolution)
+     2) measuring the period (e.g. time between rising edges)
+       - loses resolution as the frequency increases
+       - lower noise-immunity / greater impact from spurious pulses
+  - this measures the period: with a 62.5ns timestamp resolution the
+    resolution loss only starts to matter well above the frequencies the
+    optocoupled inputs can pass, and the filter takes care of the noise
+    - https://en.wikipedia.org/wiki/Exponential_smoothing
+    - e.g. https://electronics.stackexchange.com/a/34426/264328
+  - for pulse counting on the other inputs see IO22_PinChange.h
+
+  - if the input signal is disconnected the ISR won't be called and the
+    measurement would stay 'stuck' at the last reading; tick() deals with that
+    by forcing the stopped state once there have been no edges for longer than
+    the stopped threshold
+    - the ISR then restarts the measurement on the next edge: the gap
+      preceding it is not a period of the signal, so doesn't go into the
+      filter, and the filter is seeded from the first real period rather than
+      creeping up from zero or down from the gap
+  - some hysteresis is required to prevent chatter
+*/
+
+#include "Arduino.h"
+#include "IO22_FrequencyInput.h"
+#include "IO22_EventQueue.h"
+
+IO22FrequencyInput *IO22FrequencyInput::_inputs[2] = {nullptr, nullptr};
+
+// - without the vectors (IO22_FREQUENCY_INPUT_ISRS()) the interrupt enabled
+//   below would reset the board: fail instead
+bool IO22FrequencyInput::begin(uint8_t input, uint8_t edge, uint8_t filterN)
+{
+#ifdef IO22D08_AVR_M328
+  if (input < 1 || input > 2 || !_vectors || !IO22Clock::begin()) return false;
+  end();
+  _int = input - 1;
+  _filterN = filterN;
+  _primed = false;
+  _state = FS_STOPPED;
+
+  // IN1 = pin 2 (INT0), IN2 = pin 3 (INT1); the board has pullups
+  pinMode(IO22D08Traits::inputPins[_int], INPUT);
+  // ISCn1:ISCn0 = 11 rising, 10 falling
+  uint8_t shift = _int ? ISC10 : ISC00;
+  uint8_t isc = (edge == FALLING) ? 0x02 : 0x03;
+  IO22InterruptLock lock;
+  _inputs[_int] = this;
+  EICRA = (EICRA & ~(0x03 << shift)) | (isc << shift);
+  EIFR = _BV(_int);           // discard any stale edge
+  EIMSK |= _BV(_int);
+  return true;
+#else
+  (void)input; (void)edge; (void)filterN;
+  return false;
+#endif
+}
+
+void IO22FrequencyInput::end()
+{
+#ifdef IO22D08_AVR_M328
+  if (_int > 1) return;
+  IO22InterruptLock lock;
+  EIMSK &= ~_BV(_int);
+  _inputs[_int] = nullptr;
+  _int = 0xFF;
+#endif
+}
+
+void IO22FrequencyInput::setThresholds(uint32_t stopped, uint32_t lower, uint32_t upper)
+{
+  _stopped = IO22Clock::microsToCycles(stopped);
+  _lower = IO22Clock::microsToCycles(lower);
+  _upper = IO22Clock::microsToCycles(upper);
+}
+
+// this is called by the ISR; keep it short
+void IO22FrequencyInput::_isrEdge()
+{
+  uint32_t now = IO22Clock::nowFromISR();
+  uint32_t p = now - _previousEdge;
+  _previousEdge = now;
+  if (!_primed || p > _stopped)
+  {
+    // first edge, or first after the input has stopped: nothing to measure
+    // from, next edge starts the measurement
+    _primed = true;
+    _periodN = 0;
+    return;
+  }
+  if (!_periodN)
+  {
+    // first period: seed the filter
+    _periodN = p << _filterN;
+    _period = p;
+    return;
+  }
+  // have to do the filtering here to ensure we catch 'em all
+  _periodN += p - _period;
+  _period = _periodN >> _filterN;
+}
+
+uint32_t IO22FrequencyInput::getPeriodCycles()
+{
+  IO22InterruptLock lock;
+  return _period;
+}
+
+uint32_t IO22FrequencyInput::getPeriod()
+{
+  return IO22Clock::cyclesToMicros(getPeriodCycles());
+}
+
+float IO22FrequencyInput::getFrequency()
+{
+  uint32_t p = getPeriodCycles();
+  if (_state == FS_STOPPED || !p) return 0;
+  return (float)F_CPU / p;
+}
+
+IO22FrequencyInput::FSState IO22FrequencyInput::tick()
+{
+  uint32_t period, previousEdge;
+  {
+    IO22InterruptLock lock;
+    period = _period;
+    previousEdge = _previousEdge;
+  }
+  FSState previousState = _state;
+
+  // high period == low speed and vice-versa; a high enough period == stopped
+
+  // LOW-HIGH hysteresis:
+  // transition state => FS_HIGH when period is now lower than lower threshold
+  // transition state => FS_LOW when period is now higher than upper threshold
+  // no change in between
+  switch (_state)
+  {
+    case FS_STOPPED:
+      if (period && period < _stopped) _state = period > _upper ? FS_LOW : FS_HIGH;
+      break;
+    case FS_LOW:
+      if (period < _lower) _state = FS_HIGH;
+      if (period > _stopped) _state = FS_STOPPED;
+      break;
+    case FS_HIGH:
+      if (period > _upper) _state = FS_LOW;
+      if (period > _stopped) _state = FS_STOPPED;
+      break;
+  }
+
+  // no edges "recently" (longer than the _stopped period): force to stopped
+  // state
+  // - this overrides the above FSM; the ISR restarts the filter on the next
+  //   edge, there's no need (and it'd race with the ISR) to touch it here
+  if (IO22Clock::now() - previousEdge > _stopped)
+  {
+    _state = FS_STOPPED;
+    IO22InterruptLock lock;
+    _period = 0;
+  }
+
+  if (_events && _state != previousState && _int <= 1)
+    _events->push(IO22EventQueue::EVENT_FREQUENCY, _int + 1, _state);
+  return _state;
+}
@@ -0,0 +1,104 @@
+#ifndef IO22_FrequencyInput_h
+
+#define IO22_FrequencyInput_h
+
+#include "Arduino.h"
+#include "IO22_IO_Board.h"
+#include "IO22_Clock.h"
+
+class IO22EventQueue;
+
+class IO22FrequencyInput
+{
+  // frequency measurement on IN1 or IN2 (the Mini's INT0 and INT1 pins)
+  // - each edge is timestamped against the IO22Clock cycle counter (62.5ns
+  //   resolution) in the external interrupt ISR; the ISR cost is fixed (a
+  //   timestamp, a subtract and the filter update), so the cost at several
+  //   kHz is simply that x frequency
+  // - the period is smoothed by an exponential moving average filter,
+  //   x = (1-alpha).x + (alpha).u with alpha = 1/2^n: add/subtract and shifts
+  // - tick() classifies the filtered period into stopped/low/high with
+  //   hysteresis, and forces stopped if there have been no edges for longer
+  //   than the stopped threshold (the ISR can't tell that the input has gone
+  //   quiet)
+  // - Timer1 input capture would be the obvious choice, but ICP1 (pin 8) is
+  //   button K2 on this board
+  // - uses the INT0/INT1 vectors directly; they're opt-in, so only the sketch
+  //   using the input gives them up: expand IO22_FREQUENCY_INPUT_ISRS() once
+  //   in that sketch (which then can't use attachInterrupt()), along with
+  //   IO22_CLOCK_ISRS(); begin() fails without them
+
+  public:
+    enum FSState {FS_STOPPED, FS_LOW, FS_HIGH}; // Arduino LOW/HIGH be stompin'
+
+    // anything longer than this is considered DC (stopped); making this too
+    // long will slow the filter response once the signal starts up again
+    static const uint32_t PERIOD_MAX = 500*1000UL; // us; 500ms = 2Hz
+
+    IO22FrequencyInput() {}
+
+    // - input: 1 (IN1) or 2 (IN2)
+    // - edge: RISING or FALLING (the inputs are active low: FALLING = input
+    //   becoming active)
+    // - filterN: filter alpha = 1/2^filterN
+    bool begin(uint8_t input, uint8_t edge = RISING, uint8_t filterN = 2);
+    void end();
+
+    // thresholds are periods (us), not frequencies
+    void setThresholds(uint32_t stopped, uint32_t lower, uint32_t upper);
+
+    uint32_t getPeriod();               // filtered period, us
+    uint32_t getPeriodCycles();         // filtered period, IO22Clock cycles
+    float getFrequency();               // Hz, 0 when stopped
+    FSState getState() { return _state; }
+
+    // update (and return) the stopped/low/high state
+    FSState tick();
+
+    // when set, tick() pushes the state changes (see IO22_EventQueue.h)
+    void setEventQueue(IO22EventQueue *events) { _events = events; }
+
+    // ISR hooks; not for use by sketches
+    // - _vectors(): defined by IO22_FREQUENCY_INPUT_ISRS(), i.e. null unless
+    //   the sketch has the vectors
+    void _isrEdge();
+    static void _isrInterrupt(uint8_t i) { if (_inputs[i]) _inputs[i]->_isrEdge(); }
+    static void _vectors() __attribute__((weak));
+
+  protected:
+    static IO22FrequencyInput *_inputs[2];    // per INT0/INT1, while begun
+
+    // all values in this class are periods (intervals) in cycles, not
+    // frequencies
+    volatile uint32_t _previousEdge = 0;
+    volatile uint32_t _periodN = 0;     // period left-shifted (for averaging)
+    volatile uint32_t _period = 0;      // filtered period
+    volatile bool _primed = false;      // have a previous edge to measure from
+    uint32_t _stopped = IO22Clock::microsToCycles(PERIOD_MAX);
+    uint32_t _lower = 0, _upper = 0;    // lower, upper hysteresis thresholds
+    uint8_t _filterN = 2;
+    uint8_t _int = 0xFF;                // INT0/INT1; 0xFF = not started
+
+    FSState _state = FS_STOPPED;        // initial state
+    IO22EventQueue *_events = nullptr;
+};
+
+// the vectors (see above); at file scope, in the one sketch using the inputs
+#ifdef IO22D08_AVR_M328
+#define IO22_FREQUENCY_INPUT_ISRS() \
+  ISR(INT0_vect) \
+  { \
+    IO22_PROFILE_ISR_SCOPE(IO22Profiler::PROBE_FREQUENCY_ISR); \
+    IO22FrequencyInput::_isrInterrupt(0); \
+  } \
+  ISR(INT1_vect) \
+  { \
+    IO22_PROFILE_ISR_SCOPE(IO22Profiler::PROBE_FREQUENCY_ISR); \
+    IO22FrequencyInput::_isrInterrupt(1); \
+  } \
+  void IO22FrequencyInput::_vectors() {}
+#else
+#define IO22_FREQUENCY_INPUT_ISRS()
+#endif
+
+#endif
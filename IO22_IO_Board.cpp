@@ -65,125 +65,642 @@
 
 #include "Arduino.h"
 #include "IO22_IO_Board.h"
+#include "IO22_EventQueue.h"
 
-IO22D08::IO22D08() {}
+const uint8_t IO22D08Traits::inputPins[IO22D08Traits::numInputs] = {2, 3, 4, 5, 6, A0, 12, 11};
+const uint8_t IO22D08Traits::buttonPins[IO22D08Traits::numButtons] = {7, 8, 9, 10};
 
-void IO22D08::begin() {
-  pinMode(_latchPin, OUTPUT);
-  pinMode(_clockPin, OUTPUT);
-  pinMode(_dataPin, OUTPUT);
+// the glyphs are in DP a b c d e f g order (see IO22_Font.h)
+const uint16_t IO22D08Traits::characters[IO22D08Base::numCharacters] PROGMEM =
+{
+  glyph(0x7E), // 0
+  glyph(0x30), // 1
+  glyph(0x6D), // 2
+  glyph(0x79), // 3
+  glyph(0x33), // 4
+  glyph(0x5B), // 5
+  glyph(0x5F), // 6
+  glyph(0x70), // 7
+  glyph(0x7F), // 8
+  glyph(0x7B), // 9
+  glyph(0x00), // 10 ' ' (i.e. blank)
+  glyph(0x7E), // 11 O
+  glyph(0x15), // 12 n
+  glyph(0x47), // 13 F
+  glyph(0x4F), // 14 E
+  glyph(0x05), // 15 r
+  glyph(0x08), // 16 _
+};
+// the words worked out by hand in display.md
+static_assert(IO22D08Traits::glyph(0x79) == 0x6200, "IO22D08 '3'");
+static_assert(IO22D08Traits::glyph(0x33) == 0x3A00, "IO22D08 '4'");
+static_assert(IO22D08Traits::glyph(0x00) == IO22D08Traits::segmentMask, "IO22D08 blank");
+
+const uint16_t IO22D08Traits::font[IO22FontSize] PROGMEM = { IO22_FONT_ASCII(glyph) };
+
+const uint16_t IO22D08Traits::digitSelect[IO22D08Base::numDisplayDigits] PROGMEM =
+{
+  0x0400, // K1 (left-most)
+  0x0002, // K2
+  0x0004, // K3
+  0x0020, // K4 (right-most)
+};
+
+const uint8_t IO22C04Traits::inputPins[IO22C04Traits::numInputs] = {A1, A0, A3, A2};
+const uint8_t IO22C04Traits::buttonPins[IO22C04Traits::numButtons] = {2, 3, 4, 5};
+const uint8_t IO22C04Traits::relayPins[IO22C04Traits::numRelays] = {10, 11, 12, 6};
+
+// the IO22C04's display registers are wired in segment order: U3:Q0-Q7 =
+// a-g, DP (active low), U4:Q0-Q3 = K1-K4 (active high); see display.md
+const uint16_t IO22C04Traits::characters[IO22D08Base::numCharacters] PROGMEM =
+{
+  glyph(0x7E), // 0
+  glyph(0x30), // 1
+  glyph(0x6D), // 2
+  glyph(0x79), // 3
+  glyph(0x33), // 4
+  glyph(0x5B), // 5
+  glyph(0x5F), // 6
+  glyph(0x70), // 7
+  glyph(0x7F), // 8
+  glyph(0x7B), // 9
+  glyph(0x00), // 10 ' ' (i.e. blank)
+  glyph(0x7E), // 11 O
+  glyph(0x15), // 12 n
+  glyph(0x47), // 13 F
+  glyph(0x4F), // 14 E
+  glyph(0x05), // 15 r
+  glyph(0x08), // 16 _
+};
+static_assert(IO22C04Traits::glyph(0x79) == 0xB000, "IO22C04 '3'");
+
+const uint16_t IO22C04Traits::font[IO22FontSize] PROGMEM = { IO22_FONT_ASCII(glyph) };
+
+const uint16_t IO22C04Traits::digitSelect[IO22D08Base::numDisplayDigits] PROGMEM =
+{
+  0x0001, // K1 (left-most)
+  0x0002, // K2
+  0x0004, // K3
+  0x0008, // K4 (right-most)
+};
 
+const uint8_t IO22D08Base::_displayMessages[IO22D08Base::numDisplayMessages][IO22D08Base::numDisplayDigits] PROGMEM =
+{
+  {10, 10, 10, 10}, // '    '
+  {10, 10, 11, 12}, // '  On'
+  {10, 11, 13, 13}, // ' OFF'
+  {10, 14, 15, 15}, // ' Err'
+};
+
+IO22D08Base::IO22D08Base(const uint16_t *characters, const uint16_t *digitSelect,
+  uint16_t dpSegment, uint16_t segmentMask, uint8_t relayMask) :
+  _relayMask(relayMask), _characters(characters), _digitSelect(digitSelect),
+  _dpSegment(dpSegment), _segmentMask(segmentMask) {}
+
+// - the shift register pins are set up by the transport (IO22Board::begin())
+void IO22D08Traits::begin() {
   // board has pullups; even then leave this to the button library
   for (auto &i : inputPins) pinMode(i, INPUT_PULLUP);
   for (auto &i : buttonPins) pinMode(i, INPUT_PULLUP);
 
   disableRelays(); // start off, off
-  pinMode(_relayOEpin, OUTPUT);
+  pinMode(relayOEPin, OUTPUT);
 }
 
-void IO22D08::_updateDigitSelect(size_t n)
+void IO22C04Traits::begin() {
+  for (auto &i : inputPins) pinMode(i, INPUT_PULLUP);
+  for (auto &i : buttonPins) pinMode(i, INPUT_PULLUP);
+
+  disableRelays();
+  for (auto &r : relayPins) pinMode(r, OUTPUT);
+}
+
+// input snapshots
+#ifdef IO22D08_AVR_M328
+// IO22D08: remap the port bits to IN1-IN8 / K1-K4 order:
+//   IN1-IN5 = PD2-PD6, IN6 = PC0, IN7 = PB4, IN8 = PB3
+//   K1 = PD7, K2-K4 = PB0-PB2
+// - shifts by constants compile to a handful of swap/lsl/andi; ~20 cycles for
+//   all twelve channels vs. ~12 x 4us for digitalRead()
+static inline __attribute__((always_inline)) uint8_t _portsToInputs(uint8_t pd, uint8_t pb, uint8_t pc)
 {
-  // set the relevant digit select bit (common anode)
-  // - needs to be done after every buffer update
-  // - in keeping with the button sequencing, digit 1 is the left-most digit,
-  //   4 the right-most
-  _displayBuffer[n] |= _digitSelect[n];
+  return ~(((pd >> 2) & 0x1F) | ((pc & 0x01) << 5) | ((pb & 0x10) << 2) | ((pb & 0x08) << 4));
+}
+static inline __attribute__((always_inline)) uint8_t _portsToButtons(uint8_t pd, uint8_t pb)
+{
+  return ~((pd >> 7) | ((pb & 0x07) << 1)) & 0x0F;
+}
+
+uint8_t IO22D08Traits::readInputs()
+{
+  uint8_t pd = PIND, pb = PINB, pc = PINC;
+  return _portsToInputs(pd, pb, pc);
+}
+
+uint8_t IO22D08Traits::readButtons()
+{
+  uint8_t pd = PIND, pb = PINB;
+  return _portsToButtons(pd, pb);
+}
+
+uint16_t IO22D08Traits::readInputsAndButtons()
+{
+  uint8_t pd = PIND, pb = PINB, pc = PINC;
+  return _portsToInputs(pd, pb, pc) | ((uint16_t)_portsToButtons(pd, pb) << 8);
+}
+
+// IO22C04:
+//   IN1 = PC1, IN2 = PC0, IN3 = PC3, IN4 = PC2
+//   K1-K4 = PD2-PD5
+uint8_t IO22C04Traits::readInputs()
+{
+  uint8_t pc = PINC;
+  return ~(((pc >> 1) & 0x05) | ((pc << 1) & 0x0A)) & 0x0F;
+}
+
+uint8_t IO22C04Traits::readButtons()
+{
+  return ~(PIND >> 2) & 0x0F;
+}
+
+uint16_t IO22C04Traits::readInputsAndButtons()
+{
+  uint8_t pd = PIND, pc = PINC;
+  return (~(((pc >> 1) & 0x05) | ((pc << 1) & 0x0A)) & 0x0F) | ((uint16_t)(~(pd >> 2) & 0x0F) << 8);
+}
+
+// J1-J3 = PB2-PB4 (RELAY1-RELAY3 = bits 1-3), J4 = PD6 (RELAY4 = bit 4)
+// - the ports are shared with the shift register and the sketch's pins, so a
+//   read-modify-write under the lock; active high (transistor drivers)
+void IO22C04Traits::writeRelays(uint8_t relays)
+{
+  IO22InterruptLock lock;
+  PORTB = (PORTB & ~0x1C) | ((relays << 1) & 0x1C);
+  PORTD = (PORTD & ~0x40) | ((relays << 2) & 0x40);
+}
+#else
+static uint8_t _readPins(const uint8_t *pins, uint8_t n)
+{
+  uint8_t m = 0;
+  for (size_t i = 0; i < n; i++)
+    if (digitalRead(pins[i]) == LOW) m |= 1 << i;
+  return m;
+}
+
+uint8_t IO22D08Traits::readInputs()
+{
+  return _readPins(inputPins, numInputs);
+}
+
+uint8_t IO22D08Traits::readButtons()
+{
+  return _readPins(buttonPins, numButtons);
+}
+
+uint16_t IO22D08Traits::readInputsAndButtons()
+{
+  return readInputs() | ((uint16_t)readButtons() << 8);
+}
+
+uint8_t IO22C04Traits::readInputs()
+{
+  return _readPins(inputPins, numInputs);
+}
+
+uint8_t IO22C04Traits::readButtons()
+{
+  return _readPins(buttonPins, numButtons);
+}
+
+uint16_t IO22C04Traits::readInputsAndButtons()
+{
+  return readInputs() | ((uint16_t)readButtons() << 8);
+}
+
+void IO22C04Traits::writeRelays(uint8_t relays)
+{
+  for (size_t r = 0; r < numRelays; r++) digitalWrite(relayPins[r], (relays >> (r + 1)) & 1);
+}
+#endif
+
+// - inputs in bits 0-7, buttons in 8-11 whatever the board's counts (the
+//   bits of absent channels never change)
+uint16_t IO22D08Base::_scanInputs(uint16_t sample)
+{
+  uint16_t toggle = _debouncer.update(sample);
+  if (_events && toggle)
+  {
+    uint16_t state = _debouncer.state();
+    for (uint8_t b = 0; b < 12; b++)
+    {
+      if (!(toggle & (1 << b))) continue;
+      _events->push(b < 8 ? IO22EventQueue::EVENT_INPUT : IO22EventQueue::EVENT_BUTTON,
+        (b & 0x07) + 1, (state >> b) & 1);
+    }
+  }
+  return toggle;
+}
+
+
+// vertical counter debounce (after P. Dannegger)
+// - delta: channels whose sample disagrees with the debounced state
+// - the per-channel counters (cnt1:cnt0) count 1,2,3 while delta is held and
+//   are reset to 0 whenever it isn't; the state toggles on the roll-over back
+//   to 0, i.e. on the 4th consecutive disagreeing sample
+uint16_t IO22Debouncer::update(uint16_t sample)
+{
+  uint16_t delta = sample ^ _state;
+  _cnt1 = (_cnt1 ^ _cnt0) & delta;
+  _cnt0 = ~_cnt0 & delta;
+  uint16_t toggle = delta & ~(_cnt0 | _cnt1);
+  _state ^= toggle;
+  _pressed = toggle & _state;
+  _released = toggle & ~_state;
+  return toggle;
+}
+
+
+// store a fully rendered digit word, recording whether the display has
+// actually changed
+void IO22D08Base::_storeDigit(size_t n, uint16_t w)
+{
+  uint16_t *back = _backBuffer();
+  if (back[n] == w) return;
+  back[n] = w;
+  _backDirty = true;
+}
+
+// make the back buffer the one being refreshed
+// - the swap is a single byte store, the refresh (ISR) sees either the old
+//   or the new display in full; the display is only flagged dirty after the
+//   swap so the refresh evaluates the new front buffer
+// - the new back buffer is then brought up to date from the new front so
+//   partial updates (e.g. a single digit) build on the complete display
+void IO22D08Base::commitDisplay()
+{
+  if (!_backDirty) return;
+  _backDirty = false;
+  uint8_t front = _front ^ 1;
+  _front = front;
+  _displayDirty = true;
+  memcpy(_displayBuffers[front ^ 1], _displayBuffers[front], sizeof(_displayBuffers[0]));
+}
+
+void IO22D08Base::_autoCommit()
+{
+  if (!_holdCommit) commitDisplay();
+}
+
+void IO22D08Base::beginDisplayUpdate()
+{
+  _holdCommit++;
+}
+
+void IO22D08Base::endDisplayUpdate()
+{
+  if (_holdCommit) _holdCommit--;
+  _autoCommit();
+}
+
+// mix the colon (DP segments on digits 1,2) into a digit word as required
+uint16_t IO22D08Base::_mixColon(size_t n, uint16_t w)
+{
+  if (n != 1 && n != 2) return w;
+  return _displayColon ? (w & _dpSegment) : (w | ~_dpSegment);
 }
 
 // write a given character to a specific digit of the display
 // - n: digit position (0..numDisplayDigits-1)
 // - c: character (index into _characters[])
-void IO22D08::_updateDigit(size_t n, uint8_t c)
+// - the digit word is rendered in full (character, digit select bit, colon)
+//   before being stored so the buffer never holds a partial update
+void IO22D08Base::_updateDigit(size_t n, uint8_t c)
 {
-  _displayBuffer[n] =  _characters[c];
+  _updateGlyph(n, _character(c));
 }
 
-void IO22D08::_updateColon()
+// - glyph: the character's segment bits (see IO22_Font.h)
+void IO22D08Base::_updateGlyph(size_t n, uint16_t glyph)
 {
-  // mix in the colon (DP segments on digits 1,2) as required
-  if (_displayColon)
-  {
-    _displayBuffer[1] &= _dpSegment;
-    _displayBuffer[2] &= _dpSegment;
-  }
-  else
-  {
-    _displayBuffer[1] |= ~_dpSegment;
-    _displayBuffer[2] |= ~_dpSegment;
-  }
-  _updateDigitSelect(1);
-  _updateDigitSelect(2);
+  // set the relevant digit select bit (common anode)
+  // - in keeping with the button sequencing, digit 1 is the left-most digit,
+  //   4 the right-most
+  _storeDigit(n, _digitWord(n, glyph));
+}
+
+// the digit word for a glyph in position n: digit select and colon mixed in
+uint16_t IO22D08Base::_digitWord(size_t n, uint16_t glyph)
+{
+  return _mixColon(n, glyph | _digitSelectBit(n));
 }
 
-void IO22D08::displayCharacter(size_t n, uint8_t c)
+void IO22D08Base::_updateColon()
+{
+  const uint16_t *back = _backBuffer();
+  _storeDigit(1, _mixColon(1, back[1]));
+  _storeDigit(2, _mixColon(2, back[2]));
+}
+
+void IO22D08Base::displayCharacter(size_t n, uint8_t c)
 {
   _updateDigit(n, c);
-  _updateDigitSelect(n);
-  _updateColon();
+  _autoCommit();
+}
+
+void IO22D08Base::displayGlyph(size_t n, uint16_t glyph)
+{
+  _updateGlyph(n, glyph);
+  _autoCommit();
+}
+
+// the per-digit number % 10, number /= 10 would cost four ~200 cycle
+// software divisions; repeated subtraction of the powers of ten is at worst
+// ~30 compare+subtracts (9999), and more typically a handful
+// - as before, only the lower four (decimal) digits are displayed
+static inline uint8_t _decimalDigit(uint16_t &number, uint16_t power)
+{
+  uint8_t d = 0;
+  while (number >= power) { number -= power; d++; }
+  return d;
 }
 
-void IO22D08::displayNumber(uint16_t number)
+void IO22D08Base::displayNumber(uint16_t number)
+{
+  while (number >= 10000) number -= 10000;
+  uint16_t bcd = (uint16_t)_decimalDigit(number, 1000) << 12;
+  bcd |= (uint16_t)_decimalDigit(number, 100) << 8;
+  bcd |= _decimalDigit(number, 10) << 4;
+  displayBCD(bcd | number);
+}
+
+void IO22D08Base::displayBCD(uint16_t bcd)
 {
   for (size_t n = numDisplayDigits; n-- > 0;)
   {
-    _updateDigit(n, number % 10);
-    _updateDigitSelect(n);
-    number /= 10;
+    _updateDigit(n, bcd & 0x0F);
+    bcd >>= 4;
   }
-  _updateColon();
+  _autoCommit();
+}
+
+// 0-99 to packed BCD via a multiply by the reciprocal: (n * 205) >> 11 ==
+// n / 10 for n < 1029, and the AVR does have a hardware multiplier
+uint8_t IO22D08Base::_toBCD(uint8_t n)
+{
+  if (n > 99) n = 99;
+  uint8_t tens = ((uint16_t)n * 205) >> 11;
+  return (tens << 4) | (n - tens * 10);
 }
 
-void IO22D08::displayMessage(uint8_t m)
+void IO22D08Base::displayTime(uint8_t hi, uint8_t lo)
+{
+  displayBCD(((uint16_t)_toBCD(hi) << 8) | _toBCD(lo));
+}
+
+void IO22D08Base::displayMessage(uint8_t m)
 {
   for (size_t n = 0; n < numDisplayDigits; n++)
   {
-    _updateDigit(n, _displayMessages[m][n]);
-    _updateDigitSelect(n);
+    _updateDigit(n, _messageCharacter(m, n));
   }
-  _updateColon();
+  _autoCommit();
 }
 
-void IO22D08::setColon(bool state)
+void IO22D08Base::setColon(bool state)
 {
     _displayColon = state;
     _updateColon();
+    _autoCommit();
 }
 
-void IO22D08::toggleColon()
+void IO22D08Base::toggleColon()
 {
     _displayColon ^= true;
     _updateColon();
+    _autoCommit();
+}
+
+
+// a display with every digit dark (blank, no colon) doesn't need to be
+// multiplexed: once a frame has been latched it can be left alone until
+// something changes
+bool IO22D08Base::_isDisplayDark()
+{
+  const uint16_t *shown = _shownBuffer();
+  for (size_t n = 0; n < numDisplayDigits; n++)
+    if ((shown[n] & _segmentMask) != _segmentMask) return false;
+  return true;
+}
+
+// common to all refresh paths: whether there's anything to shift out and, if
+// so, take note that the pending changes are about to be
+bool IO22D08Base::_refreshNeeded()
+{
+  if (_displayDirty)
+  {
+    _displayDark = _isDisplayDark();
+    _displayDirty = false;
+  }
+  else if (_displayDark && !_relayDirty) return false;  // latched frame still valid
+  _relayDirty = false;
+  return true;
+}
+
+void IO22D08Base::frameCounts(uint32_t &shifted, uint32_t &skipped)
+{
+  IO22InterruptLock lock;
+  shifted = _framesShifted;
+  skipped = _framesSkipped;
+}
+
+void IO22D08Base::resetFrameCounts()
+{
+  IO22InterruptLock lock;
+  _framesShifted = 0;
+  _framesSkipped = 0;
+}
+
+// display sequences
+// - the sequence pointer is only swapped under the lock, and the display
+//   flagged dirty so the refresh re-evaluates what it's showing
+bool IO22D08Base::playSequence(IO22DisplaySequence &sequence)
+{
+  static_assert(IO22DisplaySequence::numDigits == numDisplayDigits, "sequence frame size");
+  IO22InterruptLock lock;
+  _sequence = nullptr;
+  if (!sequence._start()) return false;
+  _sequence = &sequence;
+  _displayDirty = true;
+  return true;
+}
+
+void IO22D08Base::stopSequence()
+{
+  IO22InterruptLock lock;
+  _sequence = nullptr;
+  _displayDirty = true;
+}
+
+// once per refresh cycle, from the refresh (ISR) while a sequence is playing
+void IO22D08Base::_sequenceTick()
+{
+  if (_sequence->_tick()) _displayDirty = true;
+}
+
+uint8_t IO22D08Base::sequenceFrame(IO22DisplaySequence &sequence, uint16_t cycles)
+{
+  return sequence.add(_backBuffer(), cycles);
+}
+
+// - blanking turns off a digit's segments but leaves its DP (the colon) as
+//   is, unless BLINK_COLON is set too
+uint8_t IO22D08Base::sequenceBlink(IO22DisplaySequence &sequence, uint8_t mask, uint16_t onCycles, uint16_t offCycles)
+{
+  const uint16_t *back = _backBuffer();
+  uint16_t digits[numDisplayDigits];
+  for (size_t n = 0; n < numDisplayDigits; n++)
+  {
+    uint16_t w = back[n];
+    if (mask & (1 << n)) w |= _segmentMask & _dpSegment;
+    if (mask & BLINK_COLON) w |= ~_dpSegment;
+    digits[n] = w;
+  }
+  uint8_t added = sequence.add(back, onCycles);
+  if (added && sequence.add(digits, offCycles)) added++;
+  return added;
+}
+
+// the digit that was last shifted out (i.e. is currently lit)
+size_t IO22D08Base::_litDigit()
+{
+  return (_refreshDigit ? _refreshDigit : numDisplayDigits) - 1;
 }
 
 
-void IO22D08::refreshDisplayAndRelays()
+// background refresh
+// - Timer2 in CTC mode, clk/128 (125kHz at 16MHz); each compare match shifts
+//   out the next digit, so each digit is lit for an equal period no matter
+//   what loop() is up to
+// - the display is refreshed at autoRefreshHz/numDisplayDigits (125Hz), well
+//   clear of visible flicker
+IO22D08Base *IO22D08Base::_autoRefreshBoard = nullptr;
+void (*IO22D08Base::_autoRefreshFn)(IO22D08Base *) = nullptr;
+void (*IO22D08Base::_autoBlankFn)(IO22D08Base *) = nullptr;
+
+void IO22D08Base::_isrAutoRefresh()
 {
-  // shift out the entire display: each digit preceded by the relay register
-  for (auto &d : _displayBuffer)
+  if (_autoRefreshBoard) _autoRefreshFn(_autoRefreshBoard);
+}
+
+void IO22D08Base::_isrAutoBlank()
+{
+  if (_autoRefreshBoard) _autoBlankFn(_autoRefreshBoard);
+}
+
+// - fn, blankFn: the owning board's (transport specific) refresh step and
+//   blank frame
+// - without the vectors (IO22_AUTO_REFRESH_ISRS()) the interrupt enabled
+//   below would reset the board: the refresh stays with loop() instead
+void IO22D08Base::_startAutoRefresh(void (*fn)(IO22D08Base *), void (*blankFn)(IO22D08Base *))
+{
+#ifdef IO22D08_AUTO_REFRESH
+  if (!_autoRefreshVectors) return;
+  IO22InterruptLock lock;
+  _autoRefreshBoard = this;
+  _autoRefreshFn = fn;
+  _autoBlankFn = blankFn;
+  _refreshDigit = 0;
+  TCCR2A = _BV(WGM21);            // CTC, TOP = OCR2A
+  TCCR2B = _BV(CS22) | _BV(CS20); // clk/128
+  OCR2A = _dwellTicks;
+  TCNT2 = 0;
+  TIFR2 = _BV(OCF2A) | _BV(OCF2B);  // discard any stale match
+  TIMSK2 |= _BV(OCIE2A);
+  _autoRefresh = true;
+  _applyBrightness();
+#else
+  (void)fn;
+  (void)blankFn;
+#endif
+}
+
+// keep the background refresh ISRs off the shift registers while loop() uses
+// them; masks only the Timer2 interrupts, not interrupts in general
+void IO22D08Base::_pauseAutoRefresh()
+{
+#ifdef IO22D08_AUTO_REFRESH
+  IO22InterruptLock lock;
+  TIMSK2 &= ~(_BV(OCIE2A) | _BV(OCIE2B));
+#endif
+}
+
+void IO22D08Base::_resumeAutoRefresh()
+{
+#ifdef IO22D08_AUTO_REFRESH
+  IO22InterruptLock lock;
+  if (!_autoRefresh) return;
+  TIMSK2 |= _BV(OCIE2A);
+  if (_brightness < 255) TIMSK2 |= _BV(OCIE2B);
+#endif
+}
+
+// the blank frame goes out OCR2B ticks into each digit's OCR2A+1 tick dwell
+// - at full brightness there's no blank frame (and no compare B interrupt)
+void IO22D08Base::_applyBrightness()
+{
+#ifdef IO22D08_AUTO_REFRESH
+  IO22InterruptLock lock;
+  if (!_autoRefresh || _brightness == 255)
   {
-    digitalWrite(_latchPin, LOW);
-    // - shiftOut() only accepts a byte at a time
-    shiftOut(_dataPin, _clockPin, MSBFIRST, lowByte(d));  // U4
-    shiftOut(_dataPin, _clockPin, MSBFIRST, highByte(d)); // U3
-    shiftOut(_dataPin, _clockPin, MSBFIRST, _relayBuffer);  // U5
-    digitalWrite(_latchPin, HIGH);
+    TIMSK2 &= ~_BV(OCIE2B);
+    return;
   }
+  OCR2B = ((uint16_t)_dwellTicks * _brightness) >> 8;
+  TIFR2 = _BV(OCF2B);
+  TIMSK2 |= _BV(OCIE2B);
+#endif
 }
 
+void IO22D08Base::setBrightness(uint8_t level)
+{
+  _brightness = level;
+  _applyBrightness();
+}
 
-// the PLC board connects the relay shift register's output enable (OE)
-// to _relayOEpin; when disabled (high impedance) the ULN2803 transistor
-// array that actually drives the relay coils will turn off all relays
-// - this is quicker than having to shift in 0's to the relay SR, and
-//   also allows the relays to be disabled and re-enabled back to their
-//   prior state
-void IO22D08::enableRelays() {
-  digitalWrite(_relayOEpin, LOW);
+// Timer2 ticks at clk/128 = 8us; OCR2A is 8 bits
+void IO22D08Base::setDigitDwell(uint16_t us)
+{
+  uint16_t ticks = us / (128000000UL / F_CPU);
+  if (ticks < 8) ticks = 8;
+  if (ticks > 256) ticks = 256;
+  _dwellTicks = ticks - 1;
+#ifdef IO22D08_AUTO_REFRESH
+  if (_autoRefresh)
+  {
+    IO22InterruptLock lock;
+    OCR2A = _dwellTicks;
+  }
+#endif
+  _applyBrightness();
 }
-void IO22D08::disableRelays() {
-  digitalWrite(_relayOEpin, HIGH);
+
+void IO22D08Base::disableAutoRefresh()
+{
+#ifdef IO22D08_AUTO_REFRESH
+  IO22InterruptLock lock;
+  TIMSK2 &= ~(_BV(OCIE2A) | _BV(OCIE2B));
+  TCCR2B = 0;                     // stop the timer
+  if (_autoRefreshBoard == this) _autoRefreshBoard = nullptr;
+  _autoRefresh = false;
+#endif
+}
+
+bool IO22D08Base::isAutoRefresh()
+{
+  return _autoRefresh;
 }
 
+
 // the relays are managed en-masse: as a set via the shift-register, not
 // individually by dedicated output pins; hence the use of octet-wide operations
 // here instead of separate bit*() ops
@@ -205,7 +722,7 @@ void IO22D08::disableRelays() {
 // e.g. relayGet(RELAY2) will return non-zero (RELAY2) if relay 2 is on
 // e.g. relayGet(R1+R3+R6) will non-zero if any of relays 1, 3 and 6 are on
 
-uint8_t IO22D08::relayNumToMask(uint8_t relayNum)
+uint8_t IO22D08Base::relayNumToMask(uint8_t relayNum)
 {
   // relays are mapped to SR outputs as 76543218
   // i.e. relay numbers 8,1-7 => bits 0,1-7
@@ -213,29 +730,106 @@ uint8_t IO22D08::relayNumToMask(uint8_t relayNum)
   return (1<<relayNum);
 }
 
-void IO22D08::relaySet(uint8_t mask, uint8_t state)
+void IO22D08Base::relaySet(uint8_t mask, uint8_t state)
 {
-  // 1) _clear_ the bits in the _relayBuffer that are to be changed (i.e.
-  //    indicated in the mask): _relayBuffer & ~mask
+  // 1) _clear_ the bits in the target that are to be changed (i.e.
+  //    indicated in the mask): _relayTarget & ~mask
   // 2) set the bits that are to be set (first masking off state to remove
   //    any extraneous bits that we shouldn't be paying attention to)
-  _relayBuffer = (_relayBuffer & ~mask) | (state & mask);
+  // - relays the board doesn't have are left alone (i.e. off)
+  // - atomic: relays may also be switched from ISRs (e.g. a frequency input);
+  //   the events for the change are pushed once the lock is released
+  uint8_t changed, relays;
+  {
+    IO22InterruptLock lock;
+    mask &= _relayMask;
+    uint8_t target = (_relayTarget & ~mask) | (state & mask);
+    _relayTarget = target;
+    // with slew: relays switching off go now, those switching on wait for
+    // _relaySlewStep()
+    changed = _applyRelays(_slewMax ? (_relayBuffer & target) : target);
+    relays = _relayBuffer;
+  }
+  _pushRelayEvents(changed, relays);
+}
+
+// the relay state to be latched (call with interrupts disabled); returns the
+// relays that changed, for _pushRelayEvents()
+uint8_t IO22D08Base::_applyRelays(uint8_t r)
+{
+  uint8_t changed = r ^ _relayBuffer;
+  if (!changed) return 0;
+  _relayBuffer = r;
+  _relayDirty = true;
+  return changed;
+}
+
+// an EVENT_RELAY per changed relay, with its state in relays
+// - outside the interrupt lock: each push reads micros() and takes its own
+//   short lock, up to 8 of them here; a change made by an ISR in between may
+//   queue its events ahead of these, each event still carries its own state
+void IO22D08Base::_pushRelayEvents(uint8_t changed, uint8_t relays)
+{
+  if (!changed || !_events) return;
+  // relay numbers 8,1-7 => bits 0,1-7 (see relayNumToMask())
+  for (uint8_t b = 0; b < 8; b++)
+    if (changed & (1 << b)) _events->push(IO22EventQueue::EVENT_RELAY, b ? b : 8, (relays >> b) & 1);
+}
+
+void IO22D08Base::setRelaySlew(uint8_t maxOn, uint16_t intervalMs)
+{
+  uint8_t changed = 0, relays;
+  {
+    IO22InterruptLock lock;
+    _slewMax = maxOn;
+    _slewInterval = intervalMs;
+    _slewLast = (uint16_t)millis() - intervalMs;  // the first step can go at once
+    if (!maxOn) changed = _applyRelays(_relayTarget);
+    relays = _relayBuffer;
+  }
+  _pushRelayEvents(changed, relays);
+}
+
+// switch on the next (up to) _slewMax pending relays, once _slewInterval has
+// passed since the previous step
+// - from the refresh paths whenever the target and the relay buffer differ;
+//   a uint16_t of millis() is plenty for intervals up to a minute
+void IO22D08Base::_relaySlewStep()
+{
+  uint8_t changed, relays;
+  {
+    IO22InterruptLock lock;
+    uint8_t pending = _relayTarget & ~_relayBuffer;
+    if (!pending) return;
+    uint16_t now = millis();
+    if ((uint16_t)(now - _slewLast) < _slewInterval) return;
+    _slewLast = now;
+    // relay number order: RELAY1-RELAY7 (bits 1-7), then RELAY8 (bit 0)
+    uint8_t on = 0;
+    uint8_t n = _slewMax;
+    for (uint8_t m = RELAY1; m && n; m <<= 1)
+      if (pending & m) { on |= m; n--; }
+    if (n && (pending & RELAY8)) on |= RELAY8;
+    changed = _applyRelays(_relayBuffer | on);
+    relays = _relayBuffer;
+  }
+  _pushRelayEvents(changed, relays);
 }
 
 // set state of a specific relay number/ID
-void IO22D08::relaySetN(uint8_t relayNum, bool state)
+void IO22D08Base::relaySetN(uint8_t relayNum, bool state)
 {
   relaySet(relayNumToMask(relayNum), state ? RELAY_ON : RELAY_OFF);
 }
 
-uint8_t IO22D08::relayGet(uint8_t mask)
+uint8_t IO22D08Base::relayGet(uint8_t mask)
 {
-  return _relayBuffer & mask;
+  return _relayTarget & mask;
 }
 
 // get state of a specific relay number/ID
 // - note, boolean return value - not RELAY_ON/RELAY_OFF
-bool IO22D08::relayIsOn(uint8_t relayNum)
+bool IO22D08Base::relayIsOn(uint8_t relayNum)
 {
-  return _relayBuffer & relayNumToMask(relayNum);
+  return _relayTarget & relayNumToMask(relayNum);
 }
\ No newline at end of file
@@ -4,18 +4,63 @@
 
 #include "Arduino.h"
 
-class IO22D08
+#include "IO22_Platform.h"
+#include "IO22_Transport.h"
+#include "IO22_Font.h"
+#include "IO22_Sequencer.h"
+#include "IO22_Profiler.h"
+
+// debounce up to 16 channels in parallel with 2-bit vertical counters
+// - bit n of each of _cnt0/_cnt1 is the two-bit counter for channel n; a
+//   channel only changes state after 4 consecutive samples that differ from
+//   its debounced state (any agreeing sample resets its counter)
+// - a handful of bitwise ops per update regardless of the number of channels,
+//   no per-channel state or timestamps
+// - update() at a fixed rate, e.g. every 5ms for a 20ms debounce
+class IO22Debouncer
+{
+  public:
+    IO22Debouncer() {}
+
+    // returns the mask of channels that changed state with this sample
+    uint16_t update(uint16_t sample);
+
+    uint16_t state() { return _state; }       // debounced state
+    uint16_t pressed() { return _pressed; }   // went active with the last update()
+    uint16_t released() { return _released; }// went inactive with the last update()
+
+  protected:
+    uint16_t _state = 0;
+    uint16_t _cnt0 = 0;
+    uint16_t _cnt1 = 0;
+    uint16_t _pressed = 0;
+    uint16_t _released = 0;
+};
+
+class IO22EventQueue;
+
+class IO22D08Base
 {
-  // this class wraps the IO22D08 hardware
-  // - TODO: generalise to support the IO22C04 variant?
-  //   - the IO22C04 has its four relay outputs directly connected to the
-  //     micro; i.e only has two shift registers for the display
+  // this class wraps the hardware common to the IO22D08 family of boards
+  // - everything that doesn't depend on the board's wiring: the display
+  //   buffers and rendering, relay state, debouncing and the background
+  //   refresh timing; see IO22Board for the board specific parts (pins, shift
+  //   register chain, input ports) and IO22D08/IO22C04 for the usual ways to
+  //   instantiate it
+  // - the rendering works from the board's font and digit select tables (in
+  //   flash) via the pointers passed in by IO22Board; the refresh paths are
+  //   compiled per board
+  // - SRAM footprint: 74 bytes per instance (double buffered display,
+  //   relay buffer, target and mask, the relay slew state,
+  //   refresh/dirty/brightness/low power/startup state, the latched
+  //   frame state and counts, the board's table pointers and masks, the input
+  //   debouncer and the event queue and sequence pointers) and 6 bytes shared (the ISR's instance and refresh/blank
+  //   pointers) plus the board's pin lists; the font, digit select and message
+  //   tables are in flash
 
   public:
     static const uint8_t numDisplayDigits = 4;
-    static const uint8_t numRelays = 8;
-    static const uint8_t numInputs = 8;
-    static const uint8_t numButtons = 4;
+    static const uint8_t numCharacters = 17;
 
     static const uint8_t numDisplayMessages = 4;
     static const uint8_t MESSAGE_BLANK = 0;
@@ -23,14 +68,61 @@ class IO22D08
     static const uint8_t MESSAGE_OFF = 2;
     static const uint8_t MESSAGE_ERR = 3;
 
-    IO22D08();
-    void begin();
+    // - characters, digitSelect: the board's font and digit select tables
+    //   (PROGMEM), dpSegment/segmentMask: its DP and all-segments masks,
+    //   relayMask: the relays it has (see IO22D08Traits)
+    IO22D08Base(const uint16_t *characters, const uint16_t *digitSelect,
+      uint16_t dpSegment, uint16_t segmentMask, uint8_t relayMask);
 
     void displayNumber(uint16_t n);
+    // division free entry points (AVR has no hardware divider)
+    // - displayBCD(): one nibble per digit, most significant = left-most;
+    //   each nibble indexes the character table directly, i.e. 0-9 plus
+    //   0xA = blank, 0xB-0xF = O, n, F, E, r
+    // - displayTime(): mm:ss style, each of hi/lo is shown as two digits
+    //   (0-99, larger values are clamped); the colon is left as is
+    void displayBCD(uint16_t bcd);
+    void displayTime(uint8_t hi, uint8_t lo);
     void setColon(bool state);
+    bool getColon() { return _displayColon; }
     void toggleColon();
     void displayCharacter(size_t n, uint8_t c);
     void displayMessage(uint8_t m);
+    // a glyph built for the board at compile time, e.g.
+    //   displayGlyph(3, IO22D08Traits::glyph(0b01100011));  // degree sign
+    // (displayText() is in IO22Board)
+    void displayGlyph(size_t n, uint16_t glyph);
+
+    // the display is double buffered: the display*() and colon functions
+    // render into a back buffer which is then committed (swapped) to the front
+    // buffer being refreshed, atomically, so a refresh can never show a
+    // partially updated (torn) display
+    // - each call commits by default; bracket a set of calls with
+    //   beginDisplayUpdate()/endDisplayUpdate() to have them show as one
+    void beginDisplayUpdate();
+    void endDisplayUpdate();
+    void commitDisplay();
+
+    // display sequences (see IO22_Sequencer.h): the refresh shows the
+    // sequence's frames in place of the display buffer, advancing once per
+    // refresh cycle, until stopped; display*() calls carry on rendering into
+    // the buffer, which shows again once the sequence is stopped
+    // - playSequence(): from the first frame; false if the sequence is empty
+    // - the builders append frames, returning the number added (0 once the
+    //   sequence is full):
+    //   - sequenceFrame(): the display as it stands (e.g. rendered within
+    //     beginDisplayUpdate()/endDisplayUpdate() so it's never shown), for
+    //     alternating frames
+    //   - sequenceBlink(): the display as it stands, then again with the digits
+    //     in mask (bit 0 = left-most, BLINK_COLON = the colon) blanked
+    //   - sequenceText() (IO22Board): scrolling text
+    static const uint8_t BLINK_COLON = 1<<4;
+    static const uint8_t BLINK_ALL = 0x1F;
+    bool playSequence(IO22DisplaySequence &sequence);
+    void stopSequence();
+    bool isSequencePlaying() { return _sequence; }
+    uint8_t sequenceFrame(IO22DisplaySequence &sequence, uint16_t cycles);
+    uint8_t sequenceBlink(IO22DisplaySequence &sequence, uint8_t mask, uint16_t onCycles, uint16_t offCycles);
 
     // relay masks
     static const uint8_t RELAY1 = 1<<1;
@@ -41,101 +133,863 @@ class IO22D08
     static const uint8_t RELAY6 = 1<<6;
     static const uint8_t RELAY7 = 1<<7;
     static const uint8_t RELAY8 = 1<<0;
+    // - a board with fewer relays (IO22C04: RELAY1-RELAY4) ignores the others
     static const uint8_t RELAYS_ALL = 0xFF;
     static const uint8_t RELAYS_NONE = 0xFF;
     static const uint8_t RELAY_ON = 0xFF;
     static const uint8_t RELAY_OFF = 0x00;
 
-    void refreshDisplayAndRelays();
-    void enableRelays();
-    void disableRelays();
+    // background refresh: a Timer2 compare interrupt shifts out one digit per
+    // tick, so loop() no longer needs to call refreshDisplayAndRelays()
+    // - takes over Timer2; the vectors are opt-in, so only a sketch using the
+    //   background refresh gives it up: expand IO22_AUTO_REFRESH_ISRS() once
+    //   in that sketch (which then can't use tone()); without them
+    //   enableAutoRefresh() does nothing (isAutoRefresh() stays false)
+    // - only one IO22D08 instance can own the timer
+    // - enableAutoRefresh() is in IO22Board
+    static const uint16_t autoRefreshHz = 500;  // digit rate; display = /4
+    void disableAutoRefresh();
+    bool isAutoRefresh();
+    // low power (enterLowPower()/exitLowPower() are in IO22Board, see also
+    // IO22Power)
+    bool isLowPower() { return _lowPower; }
+
+    // startup profiles, for IO22Board::begin()
+    // - STARTUP_SAFE: relays off and disabled until enableRelays() (the
+    //   default)
+    // - STARTUP_INSTANT_ON: the given relay state (e.g. the last one, see
+    //   IO22RelayRetain) is latched and the relays enabled first thing, with
+    //   the display blank; no slew, no relay events
+    // - STARTUP_SELF_TEST: power-on self-test, with the relays off: each
+    //   digit select and segment bit (DP and colon included) is lit on its
+    //   own in turn, selfTestStepMs each (~1s in all), then as STARTUP_SAFE
+    static const uint8_t STARTUP_SAFE = 0;
+    static const uint8_t STARTUP_INSTANT_ON = 1;
+    static const uint8_t STARTUP_SELF_TEST = 2;
+    static const uint8_t selfTestStepMs = 30;
+    // micros() at which begin() had the relays ready (latched and enabled for
+    // STARTUP_INSTANT_ON, otherwise at its end): the startup latency from the
+    // core's init(), i.e. not counting the bootloader
+    uint32_t startupMicros() { return _startupMicros; }
+
+    // brightness: each digit is lit for a share of its dwell period, then a
+    // blank frame (no digit selected) is shifted out by a second Timer2
+    // compare interrupt, so every digit gets the same on-time
+    // - level: 0 (off, or close to it) .. 255 (full, no blanking: no extra
+    //   frames); the display current scales with the level
+    // - dwell: period per digit, 64-2048us (default 1/autoRefreshHz = 2ms);
+    //   the display refresh is 4 x dwell
+    // - the background refresh does the timing; refreshDisplayAndRelays()
+    //   from loop() can only finish with a blank frame when dimmed (uniform,
+    //   but each digit is then lit for just one frame)
+    void setBrightness(uint8_t level);
+    uint8_t getBrightness() { return _brightness; }
+    void setDigitDwell(uint16_t us);
+
+    // frames shifted out to the chain, and frames skipped because the
+    // hardware already shows them (a dark frame over a dark frame with the
+    // same relay state; see display.md re. the relay byte in every frame)
+    // - bits shifted = shifted x 8 x the board's chainBytes
+    void frameCounts(uint32_t &shifted, uint32_t &skipped);
+    void resetFrameCounts();
 
     void relaySet(uint8_t mask, uint8_t state);
     uint8_t relayGet(uint8_t mask);
+    // relay slew: limit the number of relays switched on together, e.g. so
+    // relaySet(RELAYS_ALL, RELAY_ON) doesn't pull in all eight coils (~30mA
+    // each) in the same latch
+    // - at most maxOn relays are switched on per step, steps at least
+    //   intervalMs apart, in relay number order; maxOn = 0 turns it off (the
+    //   default: relays switch as soon as they're latched)
+    // - only switching on is staggered: relays switching off go at once
+    //   (less load, and an all-off shouldn't have to wait)
+    // - relaySet() still returns straight away: it sets the target state,
+    //   which the refresh (the Timer2 ISR, or refreshDisplayAndRelays()/
+    //   refreshStep()/updateRelays() from loop()) works towards; relayGet()
+    //   and relayIsOn() report the target, relayOutputs() what's switched
+    //   now, and relay events are pushed as the relays actually switch
+    void setRelaySlew(uint8_t maxOn, uint16_t intervalMs);
+    uint8_t relayOutputs() { return _relayBuffer; }
+    bool isRelaySlewing() { return _relayTarget & ~_relayBuffer; }
     // relayNum = simple numerical sequence, e.g. 3 (meaning RELAY3)
     uint8_t relayNumToMask(uint8_t n);
     void relaySetN(uint8_t relayNum, bool state);
     bool relayIsOn(uint8_t relayNum);
 
-    const uint8_t inputPins[numInputs] {2, 3, 4, 5, 6, A0, 12, 11};    // IN1-8
-    const uint8_t buttonPins[numButtons] {7, 8, 9, 10};                // K1-K4/B1-B4
+    // debounced inputs/buttons (see IO22Debouncer)
+    // - scanInputs() (IO22Board) takes a snapshot and runs it through the
+    //   debouncer; inputs in bits 0-7, buttons in 8-11 on every board
+    // - the pressed/released (edge) masks are those of the most recent scan
+    uint8_t inputState() { return lowByte(_debouncer.state()); }
+    uint8_t buttonState() { return highByte(_debouncer.state()); }
+    uint8_t inputsPressed() { return lowByte(_debouncer.pressed()); }
+    uint8_t inputsReleased() { return lowByte(_debouncer.released()); }
+    uint8_t buttonsPressed() { return highByte(_debouncer.pressed()); }
+    uint8_t buttonsReleased() { return highByte(_debouncer.released()); }
 
-  protected:
+    // event queue (see IO22_EventQueue.h): when set, scanInputs() pushes the
+    // input/button edges and relaySet() the relay changes
+    void setEventQueue(IO22EventQueue *events) { _events = events; }
 
-    // board connections
-    // ref. circuit diagram for labels
-    // - latch and clock are shared across the three shift registers
-    // - no idea why the board designers didn't use the hardware serial pins (SPI)
-    const uint8_t _latchPin = A2;
-    const uint8_t _clockPin = A3;
-    // - data is shifted out to the first register
-    const uint8_t _dataPin = 13;
+    // Timer2 ISR hooks; not for use by sketches
+    // - _autoRefreshVectors(): defined by IO22_AUTO_REFRESH_ISRS(), i.e. null
+    //   unless the sketch has the vectors
+    static void _isrAutoRefresh();
+    static void _isrAutoBlank();
+    static void _autoRefreshVectors() __attribute__((weak));
 
-    // - relay shift register (U5) output enable; active low
-    const uint8_t _relayOEpin = A1;
+  protected:
 
-    uint16_t _displayBuffer[numDisplayDigits];  // display shift register buffer (n digits x 16bits ea.)
-    uint8_t _relayBuffer = 0;                   // relay shift register buffer
+    // display shift register buffers (n digits x 16bits ea.): front (being
+    // refreshed) and back (being rendered)
+    // - only the back buffer is written; only the front is read by the
+    //   refresh, _front is swapped with a single (atomic) byte store
+    uint16_t _displayBuffers[2][numDisplayDigits];
+    volatile uint8_t _front = 0;
+    bool _backDirty = false;                    // back buffer differs from front
+    uint8_t _holdCommit = 0;                    // beginDisplayUpdate() nesting
+    volatile uint8_t _relayBuffer = 0;          // relay shift register buffer
+    volatile uint8_t _relayTarget = 0;          // relaySet() state; _relayBuffer follows
+    uint8_t _slewMax = 0;                       // relays switched on per step; 0 = no slew
+    uint16_t _slewInterval = 0;                 // ms between steps
+    uint16_t _slewLast = 0;                     // millis() of the last step
+    const uint8_t _relayMask;                   // the board's relays
+    bool _relaysEnabled = false;                // relay outputs enabled
     bool _displayColon = false;                 // enable the display colon
 
-    // constexpr should work? but results in the linker complaining:
-    //  "undefined reference to `IO22D08::characters" on dereference
-    //  when being used as: digitBuffer = characters[c];
-    // - guessing this is due to the AVR's memory architecture (and mixing thereof) ¯\_(ツ)_/¯
-    // benefit of constexpr, if it worked, would be not having to specify the size of the array
-    // constexpr static uint16_t characters[] =
-    // - see display.md for details on the 7-segment display and how the _characters
-    // constants are calculated
-    const uint16_t _characters[17] =
+    // dirty tracking: set when the buffers actually change, cleared once the
+    // change has been shifted out
+    volatile bool _displayDirty = true;
+    volatile bool _relayDirty = true;
+    bool _displayDark = false;                  // all digits blank: no need to multiplex
+    // what the chain last latched: whether that frame was dark (any digit
+    // select, no segments lit) and with which relay state
+    bool _latchedDark = false;
+    uint8_t _latchedRelays = 0;
+    uint32_t _framesShifted = 0;
+    uint32_t _framesSkipped = 0;
+
+    IO22Debouncer _debouncer;                   // inputs (bits 0-7), buttons (8-11)
+    IO22EventQueue *_events = nullptr;
+    IO22DisplaySequence *volatile _sequence = nullptr;  // playing in place of the buffer
+
+    volatile uint8_t _refreshDigit = 0;         // next digit to be shifted out
+    volatile bool _autoRefresh = false;         // Timer2 is driving the refresh
+    bool _lowPower = false;                     // display off, refresh stopped
+    bool _lowPowerAutoRefresh = false;          // to restart on exitLowPower()
+    uint32_t _startupMicros = 0;
+    uint8_t _brightness = 255;                  // digit on-time, /256 of the dwell
+    uint8_t _dwellTicks = F_CPU / 128 / autoRefreshHz - 1;  // OCR2A
+    static IO22D08Base *_autoRefreshBoard;      // instance owning Timer2
+    static void (*_autoRefreshFn)(IO22D08Base *);  // its refresh step
+    static void (*_autoBlankFn)(IO22D08Base *);    // and its blank frame
+
+    // the board's character and digit select tables live in flash (PROGMEM),
+    // read via the accessors below; the message table is common to all boards
+    // - the earlier "constexpr doesn't work" linker error ("undefined
+    //   reference to `IO22D08::characters'") was the C++11 rule that an
+    //   odr-used static constexpr member still needs a definition outside the
+    //   class; the definitions are in the .cpp
+    // - see display.md for details on the 7-segment display and how the
+    //   character constants are calculated
+    const uint16_t *_characters;
+    const uint16_t *_digitSelect;
+    // DP mask; it'll get "mixed in" to digits 2 and 3 (the colon)
+    const uint16_t _dpSegment;
+    // all segments (incl. DP); a digit is dark when all of these are high
+    const uint16_t _segmentMask;
+
+    static const uint8_t _displayMessages[numDisplayMessages][numDisplayDigits];
+
+    inline uint16_t _character(uint8_t c)
     {
-      0x2008, // 0
-      0x7A08, // 1
-      0xE000, // 2
-      0x6200, // 3
-      0x3A00, // 4
-      0x2210, // 5
-      0x2010, // 6
-      0x6A08, // 7
-      0x2000, // 8
-      0x2200, // 9
-      0xFA18, // 10 ' ' (i.e. blank)
-      0x2008, // 11 O
-      0x7810, // 12 n
-      0xA810, // 13 F
-      0xA010, // 14 E
-      0xF810, // 15 r
-      0xF218, // 16 _
-    };
-
-    // to enable a digit the appropriate K1-K4 bit needs to be set high
-    // - if the display were common cathode these constants would be
-    //   pre-inverted to skip the XOR that would otherwise be required
-    // - in keeping with the button sequencing, digit 1 is the left-most digit,
-    //   4 the right-most
-    uint16_t _digitSelect[numDisplayDigits] =
+      return pgm_read_word(&_characters[c]);
+    }
+    inline uint16_t _digitSelectBit(size_t n)
     {
-      0x0400, // K1 (left-most)
-      0x0002, // K2
-      0x0004, // K3
-      0x0020, // K4 (right-most)
-    };
-    // DP = U3:Q5; it'll get "mixed in" to each digit
-    // for the IO22D08 board only DP2 and DP3 are connected as 'colon' LEDs
-    const uint16_t _dpSegment = 0xDFFF;
-
-    const uint8_t _displayMessages[numDisplayMessages][numDisplayDigits] =
+      return pgm_read_word(&_digitSelect[n]);
+    }
+    static inline uint8_t _messageCharacter(uint8_t m, size_t n)
     {
-      {10, 10, 10, 10}, // '    '
-      {10, 10, 11, 12}, // '  On'
-      {10, 11, 13, 13}, // ' OFF'
-      {10, 14, 15, 15}, // ' Err'
-    };
+      return pgm_read_byte(&_displayMessages[m][n]);
+    }
 
+    inline uint16_t *_frontBuffer() { return _displayBuffers[_front]; }
+    inline uint16_t *_backBuffer() { return _displayBuffers[_front ^ 1]; }
+    // what the refresh shows: the sequence's frame when one's playing
+    inline const uint16_t *_shownBuffer()
+    {
+      IO22DisplaySequence *s = _sequence;
+      return s ? s->_current() : _frontBuffer();
+    }
+    void _sequenceTick();
+    void _autoCommit();
+    // debounce a snapshot (inputs in bits 0-7, buttons in 8-11)
+    uint16_t _scanInputs(uint16_t sample);
+    static uint8_t _toBCD(uint8_t n);
+    void _storeDigit(size_t n, uint16_t w);
+    uint16_t _mixColon(size_t n, uint16_t w);
+    uint16_t _digitWord(size_t n, uint16_t glyph);
+    uint8_t _applyRelays(uint8_t r);
+    void _pushRelayEvents(uint8_t changed, uint8_t relays);
+    void _relaySlewStep();
+    void _updateGlyph(size_t n, uint16_t glyph);
     void _updateDigit(size_t d, uint8_t c);
-    void _updateDigitSelect(size_t n);
     void _updateColon();
+    bool _isDisplayDark();
+    bool _refreshNeeded();
+    size_t _litDigit();
+
+    void _startAutoRefresh(void (*fn)(IO22D08Base *), void (*blankFn)(IO22D08Base *));
+    void _pauseAutoRefresh();
+    void _resumeAutoRefresh();
+    void _applyBrightness();
+
+};
+
+
+// board traits: everything IO22Board needs to know about a board, as
+// compile time constants and static (inlined) functions, so each board's
+// refresh, input and relay paths compile down to its own port operations with
+// no runtime branches on the board type
+// - numRelays/numInputs/numButtons, relayMask: the relays present (bits of the
+//   RELAY* masks), and the input/button counts
+// - chainBytes: bytes per frame, i.e. shift registers in the chain;
+//   relayShiftRegister: whether the last of those is the relay register
+//   (otherwise the relays are on pins of their own: writeRelays())
+// - glyph(): a segment pattern (see IO22_Font.h) to the board's shift
+//   register word, constexpr, from the board's segment wiring (see display.md)
+// - characters/font/digitSelect (PROGMEM), dpSegment/segmentMask: the display
+//   tables and masks; characters is the displayBCD()/displayCharacter() set,
+//   font the ASCII one
+// - begin(): sets up the input, button and relay pins (relays disabled); the
+//   transport sets up the shift register pins
+// - enableRelays()/disableRelays(): switch the relay outputs on (to the given
+//   relay state) and off
+// - DefaultTransport: the fastest transport that works on an unmodified board
+
+// IO22D08: 8 relays on a third (U5) shift register, 8 inputs, 4 buttons
+struct IO22D08Traits
+{
+  static const uint8_t numRelays = 8;
+  static const uint8_t numInputs = 8;
+  static const uint8_t numButtons = 4;
+  static const uint8_t relayMask = 0xFF;
+  static const uint8_t chainBytes = 3;          // U4, U3, U5
+  static const bool relayShiftRegister = true;
+  // relay shift register (U5) output enable; active low
+  static const uint8_t relayOEPin = A1;
+
+  static const uint8_t inputPins[numInputs];     // IN1-8: 2, 3, 4, 5, 6, A0, 12, 11
+  static const uint8_t buttonPins[numButtons];   // K1-K4/B1-B4: 7, 8, 9, 10
+
+  static const uint16_t characters[IO22D08Base::numCharacters];
+  static const uint16_t font[IO22FontSize];
+  static const uint16_t digitSelect[IO22D08Base::numDisplayDigits];
+  // DP = U3:Q5; only DP2 and DP3 are connected, as the 'colon' LEDs
+  static const uint16_t dpSegment = 0xDFFF;
+  static const uint16_t segmentMask = 0xFA18;
+  // a = U3:Q4, b = U4:Q4, c = U3:Q7, d = U3:Q3, e = U3:Q1, f = U3:Q6, g = U4:Q3
+  static constexpr uint16_t glyph(uint8_t segments)
+  {
+    return IO22Glyph(segments, segmentMask, 0x1000, 0x0010, 0x8000, 0x0800, 0x0200, 0x4000, 0x0008, 0x2000);
+  }
+
+  static void begin();
+  static uint8_t readInputs();
+  static uint8_t readButtons();
+  static uint16_t readInputsAndButtons();
+  static inline void writeRelays(uint8_t) {}   // relays are in the frame
+  static void enableRelays(uint8_t) { digitalWrite(relayOEPin, LOW); }
+  static void disableRelays() { digitalWrite(relayOEPin, HIGH); }
+
+  typedef IO22DefaultShift DefaultTransport;
+};
+
+// IO22C04: 4 relays driven directly from the micro (J1-J4: 10, 11, 12, 6), so
+// only the two display shift registers (U4 digit selects, U3 segments) in the
+// chain, 4 inputs, 4 buttons; same 88:88 display
+// - the relays keep the IO22D08's masks: RELAY1-RELAY4 (bits 1-4)
+// - the inputs are on A0-A3, so IO22FrequencyInput and IO22PinChange (which
+//   are wired to the IO22D08's IN1-IN8) don't apply
+struct IO22C04Traits
+{
+  static const uint8_t numRelays = 4;
+  static const uint8_t numInputs = 4;
+  static const uint8_t numButtons = 4;
+  static const uint8_t relayMask = 0x1E;
+  static const uint8_t chainBytes = 2;          // U4, U3
+  static const bool relayShiftRegister = false;
 
+  static const uint8_t inputPins[numInputs];     // IN1-4: A1, A0, A3, A2
+  static const uint8_t buttonPins[numButtons];   // K1-K4: 2, 3, 4, 5
+  static const uint8_t relayPins[numRelays];     // J1-J4: 10, 11, 12, 6
+
+  static const uint16_t characters[IO22D08Base::numCharacters];
+  static const uint16_t font[IO22FontSize];
+  static const uint16_t digitSelect[IO22D08Base::numDisplayDigits];
+  // DP = U3:Q7
+  static const uint16_t dpSegment = 0x7FFF;
+  static const uint16_t segmentMask = 0xFF00;
+  // a-g = U3:Q0-Q6
+  static constexpr uint16_t glyph(uint8_t segments)
+  {
+    return IO22Glyph(segments, segmentMask, 0x0100, 0x0200, 0x0400, 0x0800, 0x1000, 0x2000, 0x4000, 0x8000);
+  }
+
+  static void begin();
+  static uint8_t readInputs();
+  static uint8_t readButtons();
+  static uint16_t readInputsAndButtons();
+  static void writeRelays(uint8_t relays);
+  static void enableRelays(uint8_t relays) { writeRelays(relays); }
+  static void disableRelays() { writeRelays(0); }
+
+  typedef IO22C04DefaultShift DefaultTransport;
 };
 
 
+// the relay mask type for a chain with extraRelayBytes expanders
+template <uint8_t extraRelayBytes> struct IO22RelayWord { typedef uint32_t type; };
+template <> struct IO22RelayWord<0> { typedef uint8_t type; };
+template <> struct IO22RelayWord<1> { typedef uint16_t type; };
+
+
+// the board, with its traits and shift register transport chosen at compile
+// time
+// - Board: IO22D08Traits or IO22C04Traits (or a look-alike for another
+//   variant)
+// - Transport: one of the IO22_Transport.h classes; the default is the
+//   board's fastest one that works on an unmodified board
+// - extraRelayBytes: 74HC595 relay expanders cascaded off the end of the
+//   chain (0-3), see "Relay Expanders" in display.md
+// - the refresh paths are in the header so they're compiled (inlined) against
+//   the chosen board and transport
+template <class Board, class Transport = typename Board::DefaultTransport,
+  uint8_t extraRelayBytes = 0>
+class IO22Board : public IO22D08Base
+{
+  static_assert(extraRelayBytes <= 3, "at most 3 relay expanders (32 bit relay masks)");
+
+  public:
+    // relay masks wide enough for the board's relays and the expanders'
+    typedef typename IO22RelayWord<extraRelayBytes>::type RelayWord;
+    // as IO22D08Base's, but RelayWord wide so they reach the expanders'
+    // relays too (IO22D08Base::RELAY_ON, a byte, would turn relays 9+ off)
+    static const RelayWord RELAYS_ALL = ~(RelayWord)0;
+    static const RelayWord RELAY_ON = ~(RelayWord)0;
+
+    static const uint8_t numRelays = Board::numRelays + 8 * extraRelayBytes;
+    static const uint8_t chainBytes = Board::chainBytes + extraRelayBytes;
+    static const uint8_t numInputs = Board::numInputs;
+    static const uint8_t numButtons = Board::numButtons;
+    // the board's pin arrays themselves: range-for and sizeof work on them
+    static constexpr const uint8_t (&inputPins)[numInputs] = Board::inputPins;
+    static constexpr const uint8_t (&buttonPins)[numButtons] = Board::buttonPins;
+
+    IO22Board() : IO22D08Base(Board::characters, Board::digitSelect,
+      Board::dpSegment, Board::segmentMask, Board::relayMask) {}
+    // see STARTUP_SAFE etc. for the profiles; relays: the state for
+    // STARTUP_INSTANT_ON (including the expanders', see relaySet() below)
+    void begin(uint8_t startup = STARTUP_SAFE, RelayWord relays = 0);
+    // the power-on self-test on its own (blocking, ~1s): the relays are left
+    // as they are, the background refresh is held off for the duration
+    void selfTest();
+
+    void refreshDisplayAndRelays();
+    // incremental refresh: shift out the next digit frame only (one byte per
+    // shift register), so a refresh step never costs more than one frame;
+    // call at least 4 x 60Hz for a solid display
+    void refreshStep();
+    // time (ns) to shift out one frame with this board's transport, averaged
+    // over a number of frames of the digit that's currently lit (i.e. without
+    // disturbing the display)
+    uint32_t measureFrameCost();
+    void enableAutoRefresh();
+    // low power: blank the display and stop the refresh (Timer2, if the
+    // background refresh is running), leaving the relays latched as they are
+    // - the relay outputs stay enabled (IO22D08: OE on relayOEPin), so the
+    //   relays hold their state throughout; relaySet() + updateRelays() still
+    //   switch them (and latch a blank frame with them)
+    // - refreshDisplayAndRelays()/refreshStep() only latch relay changes
+    //   while in low power
+    // - exitLowPower() restores the display and restarts the background
+    //   refresh if it was running
+    // - for sleeping in between see IO22Power::sleep()
+    void enterLowPower();
+    void exitLowPower();
+    // latch changed relay state now (one frame) rather than on the next refresh
+    void updateRelays();
+    // the IO22D08 disables the relay shift register's outputs (OE, see
+    // disableRelays()); the IO22C04 drives its relay pins low; either way the
+    // relay state is kept and restored by enableRelays()
+    void enableRelays();
+    void disableRelays();
+
+    // relays including the expanders': bits 0-7 are the board's (RELAY1 ...
+    // RELAY8 masks), bit 8 + n is relay 9 + n (expander 1 Q0-Q7 = relays
+    // 9-16, ...), e.g. relaySet(1UL << 8 | io22d08.RELAY1, io22d08.RELAY_ON)
+    // - the board's relays go through IO22D08Base::relaySet() (slew limit,
+    //   events, ...); the expanders' are set as given and latched with the
+    //   next frame
+    // - these hide IO22D08Base's; without expanders (a byte wide RelayWord)
+    //   they come down to the same thing
+    void relaySet(RelayWord mask, RelayWord state);
+    RelayWord relayGet(RelayWord mask);
+    // relay numbers: 1 - Board::numRelays for the board's own (IO22C04: 1-4),
+    // 9 - 8 + 8 * extraRelayBytes for the expanders'; numbers in between (an
+    // IO22C04's 5-8) or past the last expander are ignored
+    void relaySetN(uint8_t relayNum, bool state);
+    bool relayIsOn(uint8_t relayNum);
+    RelayWord relayNumToMask(uint8_t relayNum)
+    {
+      if (relayNum <= 8) return IO22D08Base::relayNumToMask(relayNum);
+      return relayNum <= 8 + 8 * extraRelayBytes ? (RelayWord)1 << (relayNum - 1) : 0;
+    }
+
+    // input snapshots as bitmasks: bit 0 = IN1/K1 ... bit 7 = IN8
+    // - the inputs and buttons are active-low, the masks are active-high (i.e.
+    //   a set bit is an active input / pressed button)
+    // - on the ATmega328P taken from a single read of each of the ports, so
+    //   all channels are sampled at (within a couple of cycles of) the same
+    //   moment
+    // - readInputsAndButtons(): both in one snapshot; inputs in bits 0-7,
+    //   buttons in bits 8-11
+    uint8_t readInputs() { return Board::readInputs(); }
+    uint8_t readButtons() { return Board::readButtons(); }
+    uint16_t readInputsAndButtons() { return Board::readInputsAndButtons(); }
+
+    // scanInputs() takes a snapshot and runs it through the debouncer; call at
+    // a fixed rate (e.g. every 5ms), returns the mask of channels (inputs in
+    // bits 0-7, buttons in 8-11) that changed with this scan
+    uint16_t scanInputs();
+
+    // text from the ASCII font (IO22_Font.h), one character per digit, e.g.
+    // displayText("StOP"), displayText(F("Err")); shorter text is padded with
+    // blanks, longer is cut off, characters outside the font show as blank
+    // - a table lookup per character: no conversion at runtime
+    void displayText(const char *text);
+    void displayText(const __FlashStringHelper *text);
+    // scrolling text for a sequence: one frame per character, each shown for
+    // cycles refresh cycles, the text moving left one digit per frame and off
+    // the display (text of up to four characters is a single frame); returns
+    // the number of frames added
+    uint8_t sequenceText(IO22DisplaySequence &sequence, const char *text, uint16_t cycles);
+
+  protected:
+    // no digit selected, all segments off
+    static const uint16_t _blankFrame = Board::segmentMask;
+
+    // the expanders' relay bytes, expander 1 first; _extraPending: changed
+    // since they were last shifted out
+    volatile uint8_t _extraRelays[extraRelayBytes ? extraRelayBytes : 1] = {0};
+    volatile bool _extraPending = false;
+
+    void _setExtraRelays(RelayWord mask, RelayWord state);
+    void _shiftFrame(uint16_t d, uint8_t relays);
+    void _refreshFrame(uint16_t d, uint8_t relays);
+    static inline uint16_t _fontGlyph(uint8_t c)
+    {
+      c -= IO22FontFirst;
+      return pgm_read_word(&Board::font[c < IO22FontSize ? c : 0]);
+    }
+    static bool _isDarkFrame(uint16_t d)
+    {
+      return (d & Board::segmentMask) == Board::segmentMask;
+    }
+    void _refreshNextDigit();
+    static void _isrRefresh(IO22D08Base *board);
+    static void _isrBlank(IO22D08Base *board);
+};
+
+template <class Board, class Transport, uint8_t extraRelayBytes>
+constexpr const uint8_t (&IO22Board<Board, Transport, extraRelayBytes>::inputPins)[numInputs];
+template <class Board, class Transport, uint8_t extraRelayBytes>
+constexpr const uint8_t (&IO22Board<Board, Transport, extraRelayBytes>::buttonPins)[numButtons];
+
+// the IO22D08 with a given transport, e.g. IO22D08Board<IO22SpiShift>
+template <class Transport = IO22DefaultShift, uint8_t extraRelayBytes = 0>
+using IO22D08Board = IO22Board<IO22D08Traits, Transport, extraRelayBytes>;
+
+// the usual boards: default transport
+typedef IO22Board<IO22D08Traits> IO22D08;
+typedef IO22Board<IO22C04Traits> IO22C04;
+
+
+// - instant-on latches the relays with the first frame the chain sees: the
+//   relay outputs are disabled by Board::begin() until then, so whatever the
+//   shift registers powered up with never reaches the relays
+template <class Board, class Transport, uint8_t extraRelayBytes>
+void IO22Board<Board, Transport, extraRelayBytes>::begin(uint8_t startup, RelayWord relays)
+{
+  Transport::begin();
+  Board::begin();                   // relays start off, off
+  _relaysEnabled = false;
+  if (startup == STARTUP_INSTANT_ON)
+  {
+    for (uint8_t n = 0; n < extraRelayBytes; n++) _extraRelays[n] = relays >> (8 * (n + 1));
+    relays &= _relayMask;
+    _relayTarget = _relayBuffer = relays;
+    _relayDirty = false;
+    _relaysEnabled = true;          // the expanders' relays go out with it
+    _shiftFrame(_blankFrame, relays);
+    enableRelays();
+  }
+  else
+  {
+    // the expanders have no output enable: their relays are cleared with a
+    // frame of their own rather than left as they powered up until the first
+    // refresh
+    if (extraRelayBytes) _shiftFrame(_blankFrame, 0);
+    if (startup == STARTUP_SELF_TEST) selfTest();
+  }
+  _startupMicros = micros();
+}
+
+// one lit bit per frame: a stuck or open segment/digit line shows as a step
+// that's dark, or lights more than the one segment
+template <class Board, class Transport, uint8_t extraRelayBytes>
+void IO22Board<Board, Transport, extraRelayBytes>::selfTest()
+{
+  _pauseAutoRefresh();
+  for (size_t n = 0; n < numDisplayDigits; n++)
+  {
+    uint16_t select = _digitSelectBit(n);
+    for (uint8_t b = 0; b < 16; b++)
+    {
+      uint16_t segment = 1U << b;
+      if (!(Board::segmentMask & segment)) continue;
+      _shiftFrame(select | (Board::segmentMask & ~segment), _relayBuffer);
+      delay(selfTestStepMs);
+    }
+  }
+  _shiftFrame(_blankFrame, _relayBuffer);
+  _displayDirty = true;             // relatch the display on the next refresh
+  _resumeAutoRefresh();
+}
+
+// shift out a single digit frame: the digit followed (IO22D08) by the relay
+// register
+// - the IO22D08's relay byte has to go out with every frame: see display.md;
+//   re-latching an unchanged relay byte leaves the relay outputs untouched
+// - the IO22C04's relays are written (to their pins) along with each latch, so
+//   they take effect at the same points as the IO22D08's
+// - with expanders the frame is built in one pass, farthest register first
+//   (the last expander ... the first, U4, U3, U5), then written out from the
+//   buffer back to back; the expanders have no output enable of their own, so
+//   their relays are shifted out as off while the relays are disabled
+template <class Board, class Transport, uint8_t extraRelayBytes>
+inline void IO22Board<Board, Transport, extraRelayBytes>::_shiftFrame(uint16_t d, uint8_t relays)
+{
+  if (extraRelayBytes)
+  {
+    uint8_t frame[chainBytes];
+    uint8_t n = 0;
+    // cleared before the bytes are read: a change from loop() in between
+    // goes out with the next frame
+    _extraPending = false;
+    for (uint8_t e = extraRelayBytes; e-- > 0;) frame[n++] = _relaysEnabled ? _extraRelays[e] : 0;
+    frame[n++] = lowByte(d);
+    frame[n++] = highByte(d);
+    if (Board::relayShiftRegister) frame[n++] = relays;
+    Transport::select();
+    for (uint8_t i = 0; i < n; i++) Transport::write(frame[i]);
+  }
+  else
+  {
+    Transport::select();
+    Transport::write(lowByte(d));     // U4
+    Transport::write(highByte(d));    // U3
+    if (Board::relayShiftRegister) Transport::write(relays);   // U5
+  }
+  Transport::latch();
+  if (!Board::relayShiftRegister) Board::writeRelays(_relaysEnabled ? relays : 0);
+  _latchedDark = _isDarkFrame(d);
+  _latchedRelays = relays;
+  _framesShifted++;
+}
+
+// as _shiftFrame(), for the refresh paths: a dark frame (blank digit, or the
+// brightness blank frame) when the chain already shows a dark one with the
+// same relays would latch nothing new, so isn't shifted out at all
+// - e.g. "  On" skips 1 frame in 4, and more with dimming (blank digits then
+//   follow a blank frame)
+template <class Board, class Transport, uint8_t extraRelayBytes>
+inline void IO22Board<Board, Transport, extraRelayBytes>::_refreshFrame(uint16_t d, uint8_t relays)
+{
+  if (_latchedDark && relays == _latchedRelays && !_extraPending && _isDarkFrame(d))
+  {
+    _framesSkipped++;
+    return;
+  }
+  _shiftFrame(d, relays);
+}
+
+// - the digits are stepped through even when there's nothing to shift out,
+//   so a sequence keeps time through dark frames
+template <class Board, class Transport, uint8_t extraRelayBytes>
+void IO22Board<Board, Transport, extraRelayBytes>::_refreshNextDigit()
+{
+  if (_relayTarget != _relayBuffer) _relaySlewStep();
+  if (_refreshNeeded()) _refreshFrame(_shownBuffer()[_refreshDigit], _relayBuffer);
+  if (++_refreshDigit >= numDisplayDigits)
+  {
+    _refreshDigit = 0;
+    if (_sequence) _sequenceTick();
+  }
+}
+
+template <class Board, class Transport, uint8_t extraRelayBytes>
+void IO22Board<Board, Transport, extraRelayBytes>::refreshDisplayAndRelays()
+{
+  // the ISR owns the shift registers when the background refresh is running;
+  // shifting out from here as well would interleave with (and corrupt) its
+  // frames
+  if (_autoRefresh) return;
+  if (_lowPower)
+  {
+    updateRelays();
+    return;
+  }
+  IO22_PROFILE_SCOPE(IO22Profiler::PROBE_REFRESH);
+  if (_relayTarget != _relayBuffer) _relaySlewStep();
+  if (_refreshNeeded())  // otherwise nothing to (re)latch
+  {
+    // shift out the entire display: each digit with the relay state, read
+    // once so the whole cycle carries the same relays
+    const uint16_t *shown = _shownBuffer();
+    uint8_t relays = _relayBuffer;
+    for (size_t n = 0; n < numDisplayDigits; n++) _refreshFrame(shown[n], relays);
+    // otherwise the last digit stays lit until the next call
+    if (_brightness < 255) _refreshFrame(_blankFrame, relays);
+    _refreshDigit = 0;
+  }
+  if (_sequence) _sequenceTick();
+}
+
+template <class Board, class Transport, uint8_t extraRelayBytes>
+void IO22Board<Board, Transport, extraRelayBytes>::refreshStep()
+{
+  if (_autoRefresh) return;
+  if (_lowPower)
+  {
+    updateRelays();
+    return;
+  }
+  IO22_PROFILE_SCOPE(IO22Profiler::PROBE_REFRESH_STEP);
+  _refreshNextDigit();
+}
+
+template <class Board, class Transport, uint8_t extraRelayBytes>
+uint32_t IO22Board<Board, Transport, extraRelayBytes>::measureFrameCost()
+{
+  const uint8_t frames = 32;
+  // - interrupts are left enabled (micros() needs them over longer periods,
+  //   e.g. ~10ms via shiftOut()), so the result includes any ISR load; the
+  //   background refresh is held off though as it'd be sharing the pins
+  _pauseAutoRefresh();
+  uint16_t d = _shownBuffer()[_litDigit()];
+  unsigned long t = micros();
+  for (uint8_t n = 0; n < frames; n++) _shiftFrame(d, _relayBuffer);
+  t = micros() - t;
+  _resumeAutoRefresh();
+  return t * 1000UL / frames;
+}
+
+// latch a changed relay state right away, without waiting for (or the cost
+// of) a full display refresh
+// - re-sends the digit that is currently lit so the display is undisturbed
+// - when the background refresh is running only its (Timer2) interrupt is
+//   held off for the one frame; other interrupts remain enabled
+template <class Board, class Transport, uint8_t extraRelayBytes>
+void IO22Board<Board, Transport, extraRelayBytes>::updateRelays()
+{
+  if (_relayTarget != _relayBuffer) _relaySlewStep();
+  if (!_relayDirty) return;
+  _pauseAutoRefresh();
+  _relayDirty = false;
+  _shiftFrame(_lowPower ? _blankFrame : _shownBuffer()[_litDigit()], _relayBuffer);
+  _resumeAutoRefresh();
+}
+
+// - the blank frame goes out with the relay state as it stands, so entering
+//   low power doesn't switch any relays
+template <class Board, class Transport, uint8_t extraRelayBytes>
+void IO22Board<Board, Transport, extraRelayBytes>::enterLowPower()
+{
+  if (_lowPower) return;
+  _lowPowerAutoRefresh = _autoRefresh;
+  if (_autoRefresh) disableAutoRefresh();
+  _lowPower = true;
+  _relayDirty = false;
+  _shiftFrame(_blankFrame, _relayBuffer);
+}
+
+template <class Board, class Transport, uint8_t extraRelayBytes>
+void IO22Board<Board, Transport, extraRelayBytes>::exitLowPower()
+{
+  if (!_lowPower) return;
+  _lowPower = false;
+  _displayDirty = true;             // relatch the display on the next refresh
+  if (_lowPowerAutoRefresh) enableAutoRefresh();
+}
+
+// the IO22D08 connects the relay shift register's output enable (OE)
+// to IO22D08Traits::relayOEPin; when disabled (high impedance) the ULN2803 transistor
+// array that actually drives the relay coils will turn off all relays
+// - this is quicker than having to shift in 0's to the relay SR, and
+//   also allows the relays to be disabled and re-enabled back to their
+//   prior state
+// - the IO22C04 has no such switch: its relay pins are rewritten (off, or
+//   back to the relay state) straight away
+// - the expanders' relays follow with the next frame
+template <class Board, class Transport, uint8_t extraRelayBytes>
+void IO22Board<Board, Transport, extraRelayBytes>::enableRelays()
+{
+  _relaysEnabled = true;
+  Board::enableRelays(_relayBuffer);
+  if (extraRelayBytes) _extraPending = _relayDirty = true;
+}
+
+template <class Board, class Transport, uint8_t extraRelayBytes>
+void IO22Board<Board, Transport, extraRelayBytes>::disableRelays()
+{
+  _relaysEnabled = false;
+  Board::disableRelays();
+  if (extraRelayBytes) _extraPending = _relayDirty = true;
+}
+
+template <class Board, class Transport, uint8_t extraRelayBytes>
+void IO22Board<Board, Transport, extraRelayBytes>::relaySet(RelayWord mask, RelayWord state)
+{
+  IO22D08Base::relaySet(lowByte(mask), lowByte(state));
+  if (extraRelayBytes) _setExtraRelays(mask, state);
+}
+
+template <class Board, class Transport, uint8_t extraRelayBytes>
+typename IO22Board<Board, Transport, extraRelayBytes>::RelayWord
+  IO22Board<Board, Transport, extraRelayBytes>::relayGet(RelayWord mask)
+{
+  RelayWord r = IO22D08Base::relayGet(lowByte(mask));
+  for (uint8_t n = 0; n < extraRelayBytes; n++) r |= (RelayWord)_extraRelays[n] << (8 * (n + 1));
+  return r & mask;
+}
+
+template <class Board, class Transport, uint8_t extraRelayBytes>
+void IO22Board<Board, Transport, extraRelayBytes>::relaySetN(uint8_t relayNum, bool state)
+{
+  relaySet(relayNumToMask(relayNum), state ? ~(RelayWord)0 : 0);
+}
+
+template <class Board, class Transport, uint8_t extraRelayBytes>
+bool IO22Board<Board, Transport, extraRelayBytes>::relayIsOn(uint8_t relayNum)
+{
+  return relayGet(relayNumToMask(relayNum));
+}
+
+// - the refresh (the ISR, or the next refresh/updateRelays() call) shifts the
+//   new bytes out: unlike the board's own relays there's no slew limit
+template <class Board, class Transport, uint8_t extraRelayBytes>
+void IO22Board<Board, Transport, extraRelayBytes>::_setExtraRelays(RelayWord mask, RelayWord state)
+{
+  IO22InterruptLock lock;
+  for (uint8_t n = 0; n < extraRelayBytes; n++)
+  {
+    uint8_t m = mask >> (8 * (n + 1));
+    uint8_t r = (_extraRelays[n] & ~m) | ((state >> (8 * (n + 1))) & m);
+    if (r == _extraRelays[n]) continue;
+    _extraRelays[n] = r;
+    _extraPending = _relayDirty = true;
+  }
+}
+
+template <class Board, class Transport, uint8_t extraRelayBytes>
+uint16_t IO22Board<Board, Transport, extraRelayBytes>::scanInputs()
+{
+  IO22_PROFILE_SCOPE(IO22Profiler::PROBE_SCAN);
+  return _scanInputs(Board::readInputsAndButtons());
+}
+
+template <class Board, class Transport, uint8_t extraRelayBytes>
+void IO22Board<Board, Transport, extraRelayBytes>::displayText(const char *text)
+{
+  for (size_t n = 0; n < numDisplayDigits; n++)
+  {
+    uint8_t c = *text;
+    if (c) text++;
+    _updateGlyph(n, _fontGlyph(c));
+  }
+  _autoCommit();
+}
+
+template <class Board, class Transport, uint8_t extraRelayBytes>
+void IO22Board<Board, Transport, extraRelayBytes>::displayText(const __FlashStringHelper *text)
+{
+  const char *p = reinterpret_cast<const char *>(text);
+  for (size_t n = 0; n < numDisplayDigits; n++)
+  {
+    uint8_t c = pgm_read_byte(p);
+    if (c) p++;
+    _updateGlyph(n, _fontGlyph(c));
+  }
+  _autoCommit();
+}
+
+template <class Board, class Transport, uint8_t extraRelayBytes>
+uint8_t IO22Board<Board, Transport, extraRelayBytes>::sequenceText(IO22DisplaySequence &sequence, const char *text, uint16_t cycles)
+{
+  size_t length = strlen(text);
+  size_t frames = length > numDisplayDigits ? length : 1;
+  uint16_t digits[numDisplayDigits];
+  uint8_t added = 0;
+  for (size_t f = 0; f < frames; f++)
+  {
+    for (size_t n = 0; n < numDisplayDigits; n++)
+      digits[n] = _digitWord(n, _fontGlyph(f + n < length ? text[f + n] : ' '));
+    if (!sequence.add(digits, cycles)) break;
+    added++;
+  }
+  return added;
+}
+
+template <class Board, class Transport, uint8_t extraRelayBytes>
+void IO22Board<Board, Transport, extraRelayBytes>::_isrRefresh(IO22D08Base *board)
+{
+  static_cast<IO22Board *>(board)->_refreshNextDigit();
+}
+
+// the end of the digit's on-time
+template <class Board, class Transport, uint8_t extraRelayBytes>
+void IO22Board<Board, Transport, extraRelayBytes>::_isrBlank(IO22D08Base *board)
+{
+  IO22Board *b = static_cast<IO22Board *>(board);
+  if (!b->_displayDark) b->_refreshFrame(_blankFrame, b->_relayBuffer);
+}
+
+template <class Board, class Transport, uint8_t extraRelayBytes>
+void IO22Board<Board, Transport, extraRelayBytes>::enableAutoRefresh()
+{
+  _startAutoRefresh(&_isrRefresh, &_isrBlank);
+}
+
+
+// the background refresh's Timer2 vectors (see IO22D08Base::autoRefreshHz);
+// at file scope, in the one sketch using enableAutoRefresh()
+#ifdef IO22D08_AUTO_REFRESH
+#define IO22_AUTO_REFRESH_ISRS() \
+  ISR(TIMER2_COMPA_vect) \
+  { \
+    IO22_PROFILE_ISR_SCOPE(IO22Profiler::PROBE_REFRESH_ISR); \
+    IO22D08Base::_isrAutoRefresh(); \
+  } \
+  ISR(TIMER2_COMPB_vect) \
+  { \
+    IO22_PROFILE_ISR_SCOPE(IO22Profiler::PROBE_REFRESH_ISR); \
+    IO22D08Base::_isrAutoBlank(); \
+  } \
+  void IO22D08Base::_autoRefreshVectors() {}
+#else
+#define IO22_AUTO_REFRESH_ISRS()
+#endif
+
 #endif
@@ -0,0 +1,96 @@
+/*
+  non-blocking log for the IO22D08 examples
+
+  - at 9600 baud a character takes ~1ms; once HardwareSerial's (64 byte) TX
+    buffer is full, each print() waits for the UART to drain, stalling loop()
+    for as long as the print is: queueing the records and only writing them
+    when they fit in the TX buffer moves that wait out of loop() altogether
+  - a record's length is worked out before writing it (strlen_P() of the
+    flash strings plus the digits), so it's written whole or not at all
+*/
+
+#include "Arduino.h"
+#include "IO22_Log.h"
+
+static const __FlashStringHelper *_droppedTag()
+{
+  return F("dropped=");
+}
+
+bool IO22Log::record(const __FlashStringHelper *tag, int32_t value, const __FlashStringHelper *text)
+{
+  if ((uint8_t)(_head - _tail) >= capacity)
+  {
+    if (_dropped < 0xFF) _dropped++;
+    return false;
+  }
+  Record &r = _records[_head & _mask];
+  r.tag = tag;
+  r.text = text;
+  r.value = value;
+  _head++;
+  return true;
+}
+
+uint8_t IO22Log::_length(const Record &r)
+{
+  uint8_t n = strlen_P((PGM_P)r.tag) + 2;   // + CRLF
+  uint32_t v = r.value;
+  if (r.value < 0)
+  {
+    n++;
+    v = -v;
+  }
+  do
+  {
+    n++;
+    v /= 10;
+  } while (v);
+  if (r.text) n += strlen_P((PGM_P)r.text) + 1;
+  return n;
+}
+
+void IO22Log::_write(const Record &r)
+{
+  _out.print(r.tag);
+  _out.print((long)r.value);
+  if (r.text)
+  {
+    _out.print(':');
+    _out.print(r.text);
+  }
+  _out.println();
+}
+
+uint8_t IO22Log::flush()
+{
+  uint8_t written = 0;
+  while (_tail != _head)
+  {
+    const Record &r = _records[_tail & _mask];
+    if (_length(r) > _out.availableForWrite()) return written;
+    _write(r);
+    _tail++;
+    written++;
+  }
+  // the dropped records came after the queued ones
+  if (_dropped)
+  {
+    Record r = {_droppedTag(), nullptr, _dropped};
+    if (_length(r) > _out.availableForWrite()) return written;
+    _write(r);
+    _dropped = 0;
+  }
+  return written;
+}
+
+void IO22Log::flushAll()
+{
+  while (_tail != _head) _write(_records[_tail++ & _mask]);
+  if (_dropped)
+  {
+    Record r = {_droppedTag(), nullptr, _dropped};
+    _write(r);
+    _dropped = 0;
+  }
+}
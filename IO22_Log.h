@@ -0,0 +1,62 @@
+#ifndef IO22_Log_h
+
+#define IO22_Log_h
+
+#include "Arduino.h"
+
+class IO22Log
+{
+  // non-blocking logging: short text records queued in a ring buffer and
+  // written out only while the output has room for them
+  // - a record is a tag, a number and an optional text: "<tag><value>[:<text>]"
+  //   e.g. record(F("R"), 3, F("ON")) => "R3:ON"; the tag and text are flash
+  //   strings (F()), only the pointers are queued
+  // - flush() writes whole records while availableForWrite() says they fit,
+  //   i.e. never waits on the UART; call it every pass of loop()
+  // - keep records shorter than the TX buffer (63 characters): a longer one
+  //   would never fit
+  // - when the queue is full the record is dropped and counted; the count is
+  //   reported (as "dropped=<n>") once the queued records have been written
+  // - the output has to implement availableForWrite() (HardwareSerial does;
+  //   Print's default of 0 means nothing would ever be written)
+  // - loop() only: record() isn't safe to call from ISRs (see IO22EventQueue
+  //   for getting events out of those)
+  // - SRAM footprint: 8 bytes per record + 5
+
+  public:
+    static const uint8_t capacity = 16;
+
+    IO22Log(Print &out) : _out(out) {}
+
+    // false if the queue is full (the record's dropped)
+    bool record(const __FlashStringHelper *tag, int32_t value, const __FlashStringHelper *text = nullptr);
+
+    // write out the queued records that fit; returns the number written
+    uint8_t flush();
+    // write out all the queued records, blocking (e.g. at the end of setup())
+    void flushAll();
+
+    uint8_t pending() { return (uint8_t)(_head - _tail); }
+
+  protected:
+    static const uint8_t _mask = capacity - 1;
+    static_assert((capacity & _mask) == 0, "IO22Log capacity must be a power of two");
+
+    struct Record
+    {
+      const __FlashStringHelper *tag;
+      const __FlashStringHelper *text;
+      int32_t value;
+    };
+
+    Record _records[capacity];
+    uint8_t _head = 0;
+    uint8_t _tail = 0;
+    uint8_t _dropped = 0;
+    Print &_out;
+
+    static uint8_t _length(const Record &r);
+    void _write(const Record &r);
+};
+
+#endif
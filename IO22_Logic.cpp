@@ -0,0 +1,125 @@
+/*
+  truth table logic for the IO22 boards
+
+  - a signal number is byte * 8 + bit of the signal bytes; each cell stores
+    its signals as (byte, mask) pairs so evaluating one is four indexed loads
+    and bit tests, and SIG_FALSE is simply the byte that's always 0: no
+    branches on what a cell uses
+  - the table lookup avoids a variable shift (a loop on the AVR) with a mask
+    table
+  - the timers' running state comes from IO22RelayTimers::isActive(), the one
+    part that isn't a fixed handful of instructions: a search of at most
+    maxTimers queued timers per timer
+*/
+
+#include "Arduino.h"
+#include "IO22_Logic.h"
+
+static const uint8_t _bitMask[8] = {0x01, 0x02, 0x04, 0x08, 0x10, 0x20, 0x40, 0x80};
+
+void IO22Logic::_setCell(Cell &cell, uint16_t table, uint8_t a, uint8_t b, uint8_t c, uint8_t d)
+{
+  const uint8_t signals[4] = {a, b, c, d};
+  for (uint8_t i = 0; i < 4; i++)
+  {
+    uint8_t s = signals[i] < SIG_FALSE ? signals[i] : SIG_FALSE;
+    cell.byte[i] = s >> 3;
+    cell.mask[i] = _bitMask[s & 7];
+  }
+  cell.table[0] = lowByte(table);
+  cell.table[1] = highByte(table);
+}
+
+void IO22Logic::setRelay(uint8_t relayNum, uint16_t table, uint8_t a, uint8_t b, uint8_t c, uint8_t d)
+{
+  if (relayNum < 1 || relayNum > numRelayCells) return;
+  _setCell(_cells[relayNum - 1], table, a, b, c, d);
+  _relayCells |= _bitMask[relayNum - 1];
+}
+
+void IO22Logic::setTimer(uint8_t id, uint16_t table, uint8_t a, uint8_t b, uint8_t c, uint8_t d)
+{
+  if (id >= numTimerCells) return;
+  _setCell(_cells[numRelayCells + id], table, a, b, c, d);
+  _timerCells |= _bitMask[id];
+}
+
+void IO22Logic::clearRelay(uint8_t relayNum)
+{
+  if (relayNum < 1 || relayNum > numRelayCells) return;
+  _setCell(_cells[relayNum - 1], 0, SIG_FALSE, SIG_FALSE, SIG_FALSE, SIG_FALSE);
+  _relayCells &= ~_bitMask[relayNum - 1];
+}
+
+void IO22Logic::clearTimer(uint8_t id)
+{
+  if (id >= numTimerCells) return;
+  _setCell(_cells[numRelayCells + id], 0, SIG_FALSE, SIG_FALSE, SIG_FALSE, SIG_FALSE);
+  _timerCells &= ~_bitMask[id];
+  _timerOutputs &= ~_bitMask[id];
+}
+
+void IO22Logic::clear()
+{
+  for (auto &cell : _cells) _setCell(cell, 0, SIG_FALSE, SIG_FALSE, SIG_FALSE, SIG_FALSE);
+  _relayCells = 0;
+  _timerCells = 0;
+  _timerOutputs = 0;
+}
+
+inline uint8_t IO22Logic::_evaluateCell(const Cell &cell, const uint8_t *signals)
+{
+  uint8_t i = 0;
+  if (signals[cell.byte[0]] & cell.mask[0]) i |= 1;
+  if (signals[cell.byte[1]] & cell.mask[1]) i |= 2;
+  if (signals[cell.byte[2]] & cell.mask[2]) i |= 4;
+  if (signals[cell.byte[3]] & cell.mask[3]) i |= 8;
+  return cell.table[i >> 3] & _bitMask[i & 7];
+}
+
+void IO22Logic::_gatherSignals()
+{
+  uint8_t frequency = 0;
+  for (uint8_t f = 0; f < 2; f++)
+  {
+    if (!_frequency[f]) continue;
+    IO22FrequencyInput::FSState state = _frequency[f]->getState();
+    if (state == IO22FrequencyInput::FS_HIGH) frequency |= _bitMask[4 + f];
+    if (state != IO22FrequencyInput::FS_STOPPED) frequency |= _bitMask[6 + f];
+  }
+  uint8_t timers = 0;
+  if (_timers)
+    for (uint8_t id = 0; id < numTimerCells; id++)
+      if (_timers->isActive(id)) timers |= _bitMask[id];
+
+  _signals[0] = _board.inputState();
+  _signals[1] = (_board.buttonState() & 0x0F) | frequency;
+  _signals[2] = timers;
+  _signals[3] = _maskToNumbers(_board.relayGet(IO22D08Base::RELAYS_ALL));
+  _signals[4] = _board.inputsPressed();
+  _signals[5] = (_board.buttonsPressed() & 0x0F) | (_board.buttonsReleased() << 4);
+  _signals[6] = _board.inputsReleased();
+  _signals[7] = 0;                  // SIG_FALSE
+}
+
+uint8_t IO22Logic::evaluate()
+{
+  _gatherSignals();
+  uint8_t relays = 0, timers = 0;
+  for (uint8_t c = 0; c < numRelayCells; c++)
+    if (_evaluateCell(_cells[c], _signals)) relays |= _bitMask[c];
+  for (uint8_t c = 0; c < numTimerCells; c++)
+    if (_evaluateCell(_cells[numRelayCells + c], _signals)) timers |= _bitMask[c];
+
+  uint8_t mask = _numbersToMask(_relayCells);
+  uint8_t state = _numbersToMask(relays);
+  uint8_t switched = (_board.relayGet(mask) ^ state) & mask;
+  if (switched) _board.relaySet(mask, state);
+
+  uint8_t start = timers & ~_timerOutputs & _timerCells;
+  _timerOutputs = timers;
+  if (start && _timers)
+    for (uint8_t id = 0; id < numTimerCells; id++)
+      if (start & _bitMask[id]) _timers->start(id);
+  return switched;
+}
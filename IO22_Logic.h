@@ -0,0 +1,116 @@
+#ifndef IO22_Logic_h
+
+#define IO22_Logic_h
+
+#include "Arduino.h"
+#include "IO22_IO_Board.h"
+#include "IO22_RelayTimers.h"
+#include "IO22_FrequencyInput.h"
+
+// a PLC-style logic program, evaluated once per scan: each relay (and each
+// relay timer's start) is a truth table over up to 4 signals, the inputs and
+// buttons (levels and edges), the frequency switch states, the timers and the
+// relays themselves (for latching)
+// - a table has a bit per combination of its signals a-d: the output for
+//   a = 1, b = 0, c = 1, d = 0 is bit 0b0101 = 5; unused signals are
+//   SIG_FALSE, so a table over two signals only looks at bits 0-3 (the
+//   TABLE_* constants repeat their pattern, so work for either)
+// - evaluate() gathers the signals into a few bytes, then runs every cell of
+//   the program whether it's in use or not: the same handful of bit tests
+//   and a lookup per cell, so the time taken doesn't depend on the program;
+//   the relays are then switched together in a single relaySet() (only
+//   those that have a cell; the others stay with the sketch)
+// - timer cells start their timer on the output's rising edge (the timer
+//   stops itself, see IO22RelayTimers)
+// - the program is plain data (setRelay()/setTimer()), e.g. to keep in
+//   EEPROM alongside the settings
+// - SRAM footprint: 10 bytes per cell (16 cells) + 19
+class IO22Logic
+{
+  public:
+    // signals: IN1-IN8 bits 0-7, K1-K4 8-11 (debounced, active = 1)
+    static const uint8_t SIG_IN1 = 0;
+    static const uint8_t SIG_K1 = 8;
+    // frequency inputs 1, 2 (setFrequencyInputs()): high (FS_HIGH), running
+    // (FS_LOW or FS_HIGH, i.e. not stopped)
+    static const uint8_t SIG_FREQ1_HIGH = 12;
+    static const uint8_t SIG_FREQ2_HIGH = 13;
+    static const uint8_t SIG_FREQ1_RUNNING = 14;
+    static const uint8_t SIG_FREQ2_RUNNING = 15;
+    // relay timers 0-7 running
+    static const uint8_t SIG_TIMER0 = 16;
+    // relays 1-8, the relaySet() target as the scan found it
+    static const uint8_t SIG_RELAY1 = 24;
+    // edges, for this scan only: IN1-IN8 and K1-K4 pressed/released
+    static const uint8_t SIG_PRESSED_IN1 = 32;
+    static const uint8_t SIG_PRESSED_K1 = 40;
+    static const uint8_t SIG_RELEASED_K1 = 44;
+    static const uint8_t SIG_RELEASED_IN1 = 48;
+    // always 0
+    static const uint8_t SIG_FALSE = 56;
+
+    // common tables, over a (and b, c)
+    static const uint16_t TABLE_A = 0xAAAA;         // a, e.g. relay follows input
+    static const uint16_t TABLE_NOT_A = 0x5555;
+    static const uint16_t TABLE_A_AND_B = 0x8888;
+    static const uint16_t TABLE_A_OR_B = 0xEEEE;
+    static const uint16_t TABLE_A_AND_NOT_B = 0x2222;
+    // toggle: a = the edge, b = the relay itself
+    static const uint16_t TABLE_A_XOR_B = 0x6666;
+    // set/reset latch: a = set, b = reset, c = the relay itself; set wins
+    static const uint16_t TABLE_SET_RESET = 0xBABA;
+
+    static const uint8_t numRelayCells = 8;
+    static const uint8_t numTimerCells = IO22RelayTimers::maxTimers;
+    static const uint8_t numSignalBytes = 8;
+
+    IO22Logic(IO22D08Base &board, IO22RelayTimers *timers = nullptr) :
+      _board(board), _timers(timers) { clear(); }
+    void setFrequencyInputs(IO22FrequencyInput *input1, IO22FrequencyInput *input2 = nullptr)
+    {
+      _frequency[0] = input1;
+      _frequency[1] = input2;
+    }
+
+    // program a relay (1-8) / timer (0-7) cell; a-d: SIG_* signal numbers
+    void setRelay(uint8_t relayNum, uint16_t table, uint8_t a, uint8_t b = SIG_FALSE,
+      uint8_t c = SIG_FALSE, uint8_t d = SIG_FALSE);
+    void setTimer(uint8_t id, uint16_t table, uint8_t a, uint8_t b = SIG_FALSE,
+      uint8_t c = SIG_FALSE, uint8_t d = SIG_FALSE);
+    // hand a relay back to the sketch / drop a timer cell / everything
+    void clearRelay(uint8_t relayNum);
+    void clearTimer(uint8_t id);
+    void clear();
+
+    // once per scan, after scanInputs() (the edge signals are that scan's);
+    // returns the relays switched (mask)
+    uint8_t evaluate();
+
+  protected:
+    // a signal is a byte of the signal bytes and a bit mask
+    struct Cell
+    {
+      uint8_t byte[4];
+      uint8_t mask[4];
+      uint8_t table[2];     // bits 0-7, 8-15
+    };
+
+    IO22D08Base &_board;
+    IO22RelayTimers *_timers;
+    IO22FrequencyInput *_frequency[2] = {nullptr, nullptr};
+    Cell _cells[numRelayCells + numTimerCells];
+    uint8_t _signals[numSignalBytes];
+    uint8_t _relayCells = 0;      // bit n-1 = relay n has a cell
+    uint8_t _timerCells = 0;
+    uint8_t _timerOutputs = 0;    // timer cell outputs, last evaluate()
+
+    void _setCell(Cell &cell, uint16_t table, uint8_t a, uint8_t b, uint8_t c, uint8_t d);
+    static uint8_t _evaluateCell(const Cell &cell, const uint8_t *signals);
+    void _gatherSignals();
+    // relay numbers (bit n-1 = relay n) <-> relay masks (RELAY1 = bit 1 ...
+    // RELAY8 = bit 0): a rotate by one
+    static uint8_t _numbersToMask(uint8_t b) { return (b << 1) | (b >> 7); }
+    static uint8_t _maskToNumbers(uint8_t m) { return (m >> 1) | (m << 7); }
+};
+
+#endif
@@ -0,0 +1,359 @@
+/*
+  Modbus RTU slave for the IO22 boards
+
+  - frame timing: each received byte pushes Timer1's compare B out to 3.5
+    characters from now; the compare only fires once the line has been quiet
+    that long, which is the end of the frame (the 1.5 character inter-byte
+    limit isn't checked separately: a frame broken up that way fails its CRC
+    or is dropped as too short)
+  - the frame buffer belongs to the RX ISR while receiving, to poll() from the
+    end of the frame until the response is handed over, and then to the UDRE
+    ISR until the last bit is out (TXC, which also drops the RS485 driver
+    enable); bytes arriving while it isn't the RX ISR's (e.g. the transmitter's
+    own echo) are discarded
+  - responses reuse the request's header: a read's data overwrites the
+    request's start/count (saved first), a single write's response is the
+    request itself, a multiple write's the request's first six bytes
+*/
+
+#include "Arduino.h"
+#include "IO22_ModbusRTU.h"
+
+uint8_t IO22ModbusRTU::_buffer[IO22ModbusRTU::bufferSize];
+volatile uint8_t IO22ModbusRTU::_length = 0;
+volatile uint8_t IO22ModbusRTU::_sent = 0;
+volatile uint8_t IO22ModbusRTU::_state = IO22ModbusRTU::STATE_RECEIVING;
+volatile bool IO22ModbusRTU::_frameError = false;
+volatile uint16_t IO22ModbusRTU::_crc = IO22Crc16::initial;
+uint16_t IO22ModbusRTU::_silenceCycles = 0;
+uint8_t IO22ModbusRTU::_driverEnablePin = IO22ModbusRTU::noDriverEnable;
+
+static const uint8_t FC_READ_COILS = 0x01;
+static const uint8_t FC_READ_DISCRETE_INPUTS = 0x02;
+static const uint8_t FC_READ_HOLDING_REGISTERS = 0x03;
+static const uint8_t FC_WRITE_SINGLE_COIL = 0x05;
+static const uint8_t FC_WRITE_SINGLE_REGISTER = 0x06;
+static const uint8_t FC_WRITE_MULTIPLE_COILS = 0x0F;
+static const uint8_t FC_WRITE_MULTIPLE_REGISTERS = 0x10;
+
+static const int8_t ILLEGAL_FUNCTION = -1;
+static const int8_t ILLEGAL_DATA_ADDRESS = -2;
+static const int8_t ILLEGAL_DATA_VALUE = -3;
+
+#ifdef IO22D08_AVR_M328
+
+// - without the vectors (IO22_MODBUS_RTU_ISRS()) the interrupts enabled below
+//   would reset the board: do nothing instead
+void IO22ModbusRTU::begin(uint32_t baud, uint8_t address, uint8_t driverEnablePin, uint8_t parity)
+{
+  if (!_vectors || !IO22Clock::begin()) return;
+  _address = address;
+  _driverEnablePin = driverEnablePin;
+  if (driverEnablePin != noDriverEnable)
+  {
+    digitalWrite(driverEnablePin, LOW);
+    pinMode(driverEnablePin, OUTPUT);
+  }
+  // 3.5 characters of 11 bits, or the spec's fixed 1750us above 19200 baud
+  uint32_t silence = baud > 19200 ? IO22Clock::microsToCycles(1750)
+                                  : F_CPU / baud * 385 / 10;
+  _silenceCycles = silence > 0xFFFF ? 0xFFFF : silence;
+
+  IO22InterruptLock lock;
+  UBRR0 = (F_CPU / 4 / baud - 1) / 2;     // double speed, rounded
+  UCSR0A = _BV(U2X0);
+  UCSR0C = _BV(UCSZ01) | _BV(UCSZ00) |
+    (parity == PARITY_EVEN ? _BV(UPM01) : parity == PARITY_ODD ? _BV(UPM01) | _BV(UPM00) : 0);
+  UCSR0B = _BV(RXEN0) | _BV(TXEN0) | _BV(RXCIE0);
+  _receiveNext();
+}
+
+void IO22ModbusRTU::end()
+{
+  IO22InterruptLock lock;
+  UCSR0B = 0;
+  TIMSK1 &= ~_BV(OCIE1B);
+  if (_driverEnablePin != noDriverEnable) digitalWrite(_driverEnablePin, LOW);
+}
+
+void IO22ModbusRTU::_isrReceive()
+{
+  uint8_t status = UCSR0A;          // error flags are for the byte in UDR0
+  uint8_t b = UDR0;
+  if (_state != STATE_RECEIVING) return;
+  if (status & (_BV(FE0) | _BV(DOR0) | _BV(UPE0))) _frameError = true;
+  uint8_t n = _length;
+  if (n < bufferSize)
+  {
+    _buffer[n] = b;
+    _length = n + 1;
+    _crc = IO22Crc16::update(_crc, b);
+  }
+  else
+    _frameError = true;
+  OCR1B = TCNT1 + _silenceCycles;
+  TIFR1 = _BV(OCF1B);
+  TIMSK1 |= _BV(OCIE1B);
+}
+
+void IO22ModbusRTU::_isrFrameEnd()
+{
+  TIMSK1 &= ~_BV(OCIE1B);
+  if (_state == STATE_RECEIVING && _length) _state = STATE_FRAME;
+}
+
+void IO22ModbusRTU::_isrTransmit()
+{
+  uint8_t n = _sent;
+  UDR0 = _buffer[n++];
+  _sent = n;
+  if (n >= _length) UCSR0B = (UCSR0B & ~_BV(UDRIE0)) | _BV(TXCIE0);
+}
+
+void IO22ModbusRTU::_isrTransmitComplete()
+{
+  UCSR0B &= ~_BV(TXCIE0);
+  if (_driverEnablePin != noDriverEnable) digitalWrite(_driverEnablePin, LOW);
+  _receiveNext();
+}
+
+void IO22ModbusRTU::_respond(uint8_t length)
+{
+  uint16_t crc = IO22Crc16::update(IO22Crc16::initial, _buffer, length);
+  _buffer[length++] = lowByte(crc);     // CRC goes out low byte first
+  _buffer[length++] = highByte(crc);
+  if (_driverEnablePin != noDriverEnable) digitalWrite(_driverEnablePin, HIGH);
+  IO22InterruptLock lock;
+  _length = length;
+  _sent = 0;
+  _state = STATE_SENDING;
+  UCSR0A = (UCSR0A & _BV(U2X0)) | _BV(TXC0);   // clear a stale TX complete
+  UCSR0B |= _BV(UDRIE0);
+}
+
+#else
+
+void IO22ModbusRTU::begin(uint32_t, uint8_t address, uint8_t driverEnablePin, uint8_t)
+{
+  _address = address;
+  _driverEnablePin = driverEnablePin;
+}
+
+void IO22ModbusRTU::end()
+{
+}
+
+void IO22ModbusRTU::_isrReceive()
+{
+}
+
+void IO22ModbusRTU::_isrFrameEnd()
+{
+}
+
+void IO22ModbusRTU::_isrTransmit()
+{
+}
+
+void IO22ModbusRTU::_isrTransmitComplete()
+{
+}
+
+void IO22ModbusRTU::_respond(uint8_t)
+{
+  _receiveNext();
+}
+
+#endif
+
+void IO22ModbusRTU::_receiveNext()
+{
+  IO22InterruptLock lock;
+  _length = 0;
+  _crc = IO22Crc16::initial;
+  _frameError = false;
+  _state = STATE_RECEIVING;
+}
+
+bool IO22ModbusRTU::poll()
+{
+  if (_state != STATE_FRAME) return false;
+  IO22_PROFILE_SCOPE(IO22Profiler::PROBE_MODBUS);
+  // the smallest frame is address, function code and CRC
+  if (_frameError || _length < 4 || _crc != 0)
+  {
+    _errors++;
+    _receiveNext();
+    return false;
+  }
+  uint8_t address = _buffer[0];
+  if (address != _address && address != 0)
+  {
+    _receiveNext();
+    return false;
+  }
+  _requests++;
+  int8_t length = _serve(address == 0);
+  if (address == 0 || length == 0)
+  {
+    _receiveNext();
+    return true;
+  }
+  if (length < 0)
+  {
+    _buffer[1] |= 0x80;
+    _buffer[2] = -length;
+    length = 3;
+    _exceptions++;
+  }
+  _respond(length);
+  return true;
+}
+
+int8_t IO22ModbusRTU::_serve(bool broadcast)
+{
+  uint8_t function = _buffer[1];
+  uint8_t length = _length - 2;     // without the CRC
+  uint16_t start = _word(2);
+  uint16_t count = _word(4);        // or the value, for the single writes
+  switch (function)
+  {
+    case FC_READ_COILS:
+    case FC_READ_DISCRETE_INPUTS:
+      if (broadcast) return 0;
+      if (length != 6) return ILLEGAL_DATA_VALUE;
+      return _readBits(start, count, function == FC_READ_COILS ? numCoils : numDiscreteInputs,
+        function == FC_READ_COILS);
+
+    case FC_READ_HOLDING_REGISTERS:
+      if (broadcast) return 0;
+      if (length != 6) return ILLEGAL_DATA_VALUE;
+      return _readRegisters(start, count);
+
+    case FC_WRITE_SINGLE_COIL:
+      if (length != 6 || (count != 0xFF00 && count != 0)) return ILLEGAL_DATA_VALUE;
+      if (start >= numCoils) return ILLEGAL_DATA_ADDRESS;
+      _board.relaySetN(start + 1, count);
+      return 6;                     // the response is the request
+
+    case FC_WRITE_SINGLE_REGISTER:
+      if (length != 6) return ILLEGAL_DATA_VALUE;
+      if (!_writeRegister(start, count)) return ILLEGAL_DATA_ADDRESS;
+      return 6;
+
+    case FC_WRITE_MULTIPLE_COILS:
+    {
+      uint8_t bytes = _buffer[6];
+      if (count < 1 || bytes != (count + 7) / 8 || length != 7 + bytes) return ILLEGAL_DATA_VALUE;
+      if (start >= numCoils || count > numCoils - start) return ILLEGAL_DATA_ADDRESS;
+      // all the coils in one relaySet(): they switch together
+      uint8_t mask = 0, state = 0;
+      for (uint8_t i = 0; i < count; i++)
+      {
+        uint8_t relay = _board.relayNumToMask(start + i + 1);
+        mask |= relay;
+        if (_buffer[7 + i / 8] & _BV(i % 8)) state |= relay;
+      }
+      _board.relaySet(mask, state);
+      return 6;
+    }
+
+    case FC_WRITE_MULTIPLE_REGISTERS:
+    {
+      uint8_t bytes = _buffer[6];
+      if (count < 1 || bytes != count * 2 || length != 7 + bytes) return ILLEGAL_DATA_VALUE;
+      uint16_t value;
+      for (uint16_t i = 0; i < count; i++)
+        if (!_readRegister(start + i, value)) return ILLEGAL_DATA_ADDRESS;
+      for (uint16_t i = 0; i < count; i++) _writeRegister(start + i, _word(7 + 2 * i));
+      return 6;
+    }
+  }
+  return ILLEGAL_FUNCTION;
+}
+
+int8_t IO22ModbusRTU::_readBits(uint16_t start, uint16_t count, uint16_t limit, bool coils)
+{
+  if (count < 1 || count > limit) return ILLEGAL_DATA_VALUE;
+  // (not start + count > limit: in a 16 bit int that wraps for a start near
+  // 0xFFFF)
+  if (start >= limit || count > limit - start) return ILLEGAL_DATA_ADDRESS;
+  uint16_t bits = 0;
+  if (coils)
+  {
+    for (uint8_t i = 0; i < numCoils; i++)
+      if (_board.relayIsOn(i + 1)) bits |= _BV(i);
+  }
+  else
+    bits = _board.inputState() | ((uint16_t)_board.buttonState() << 8);
+  bits = (bits >> start) & ((1U << count) - 1);
+  uint8_t bytes = (count + 7) / 8;
+  _buffer[2] = bytes;
+  _buffer[3] = lowByte(bits);
+  _buffer[4] = highByte(bits);
+  return 3 + bytes;
+}
+
+int8_t IO22ModbusRTU::_readRegisters(uint16_t start, uint16_t count)
+{
+  if (count < 1 || count > (bufferSize - 5) / 2) return ILLEGAL_DATA_VALUE;
+  uint16_t value;
+  for (uint16_t i = 0; i < count; i++)
+    if (!_readRegister(start + i, value)) return ILLEGAL_DATA_ADDRESS;
+  _buffer[2] = count * 2;
+  for (uint16_t i = 0; i < count; i++)
+  {
+    _readRegister(start + i, value);
+    _putWord(3 + 2 * i, value);
+  }
+  return 3 + count * 2;
+}
+
+bool IO22ModbusRTU::_readRegister(uint16_t reg, uint16_t &value)
+{
+  switch (reg)
+  {
+    case REG_NUMBER: value = _number; return true;
+    case REG_BCD: value = _bcd; return true;
+    case REG_COLON: value = _board.getColon(); return true;
+    case REG_BRIGHTNESS: value = _board.getBrightness(); return true;
+  }
+  if (!_timers) return false;
+  if (reg >= REG_TIMER_TIMEOUT && reg < REG_TIMER_TIMEOUT + IO22RelayTimers::maxTimers)
+  {
+    value = _timers->timeout(reg - REG_TIMER_TIMEOUT);
+    return true;
+  }
+  if (reg >= REG_TIMER_REMAINING && reg < REG_TIMER_REMAINING + IO22RelayTimers::maxTimers)
+  {
+    uint32_t ms = _timers->timeRemaining(reg - REG_TIMER_REMAINING);
+    value = ms == IO22RelayTimers::noDeadline ? 0 : (ms + 999) / 1000;
+    return true;
+  }
+  return false;
+}
+
+bool IO22ModbusRTU::_writeRegister(uint16_t reg, uint16_t value)
+{
+  switch (reg)
+  {
+    case REG_NUMBER: _number = value; _board.displayNumber(value); return true;
+    case REG_BCD: _bcd = value; _board.displayBCD(value); return true;
+    case REG_COLON: _board.setColon(value); return true;
+    case REG_BRIGHTNESS: _board.setBrightness(value > 255 ? 255 : value); return true;
+  }
+  if (!_timers) return false;
+  if (reg >= REG_TIMER_TIMEOUT && reg < REG_TIMER_TIMEOUT + IO22RelayTimers::maxTimers)
+  {
+    uint8_t id = reg - REG_TIMER_TIMEOUT;
+    _timers->setTimeout(id, _timers->relayMask(id), value);
+    return true;
+  }
+  if (reg >= REG_TIMER_REMAINING && reg < REG_TIMER_REMAINING + IO22RelayTimers::maxTimers)
+  {
+    uint8_t id = reg - REG_TIMER_REMAINING;
+    if (value) _timers->start(id); else _timers->stop(id);
+    return true;
+  }
+  return false;
+}
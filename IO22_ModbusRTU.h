@@ -0,0 +1,165 @@
+#ifndef IO22_ModbusRTU_h
+
+#define IO22_ModbusRTU_h
+
+#include "Arduino.h"
+#include "IO22_IO_Board.h"
+#include "IO22_RelayTimers.h"
+#include "IO22_Clock.h"
+#include "IO22_Profiler.h"
+
+// Modbus RTU slave on the hardware UART (USART0), e.g. via an RS485 module
+// with its driver enable (DE/RE) on a spare pin
+// - reception is interrupt driven: the RX ISR appends each byte to the frame
+//   buffer and updates a running CRC, and restarts a Timer1 compare (OCR1B,
+//   alongside IO22Clock) for the 3.5 character silence that ends a frame; a
+//   frame is therefore checked by the time it's complete (CRC over the whole
+//   frame = 0)
+// - poll() from loop() serves a complete frame: the response is built in
+//   place in the frame buffer, straight from the board's relay, input and
+//   display state, and sent by the UDRE ISR; nothing is copied or queued
+// - the ISRs are a few us per character (~87us apart at 115200 baud), so the
+//   Timer2 display refresh is never held up by more than that
+// - function codes 01/05/0F (coils), 02 (discrete inputs), 03/06/10 (holding
+//   registers); broadcasts (address 0) are served for the writes only and
+//   never answered; requests for anything else get the standard exception
+//   responses (01 illegal function, 02 illegal data address, 03 illegal data
+//   value)
+// - uses the USART0 vectors and Timer1's compare B directly, and starts
+//   IO22Clock; the vectors are opt-in, so only the sketch using the slave
+//   gives them up: expand IO22_MODBUS_RTU_ISRS() once in that sketch (which
+//   then can't use Serial, or IO22UsartShift), along with IO22_CLOCK_ISRS();
+//   begin() does nothing without them
+// - 9600 baud and up (the 3.5 character silence has to fit Timer1's 16 bits:
+//   4ms at 9600); above 19200 the fixed 1750us of the spec
+// - ATmega328P only; elsewhere begin() does nothing and poll() never sees
+//   a request
+//
+// register map (addresses from 0):
+// - coils 0-7: relays 1-8 (relaySetN()/relayIsOn(), i.e. the relaySet()
+//   target state); a board with fewer relays reads the others as off, and
+//   ignores writes to them
+// - discrete inputs 0-11: IN1-IN8, K1-K4, debounced (as of the last
+//   scanInputs())
+// - holding registers:
+//   - 0: number shown (displayNumber(); reads back the last written value)
+//   - 1: BCD shown (displayBCD(); ditto)
+//   - 2: colon, 0/1
+//   - 3: brightness, 0-255
+//   - 16-23: relay timer 0-7 timeout (s), when relay timers are attached
+//   - 24-31: relay timer 0-7 time remaining (s, rounded up; 0 = stopped);
+//     writing starts the timer (any non-zero value) or stops it (0)
+class IO22ModbusRTU
+{
+  public:
+    static const uint8_t PARITY_NONE = 0;   // 8N1
+    static const uint8_t PARITY_EVEN = 1;   // 8E1, the Modbus default
+    static const uint8_t PARITY_ODD = 2;    // 8O1
+    static const uint8_t noDriverEnable = 0xFF;
+    // the frame buffer: requests that don't fit are dropped, and reads are
+    // limited to what fits in the response
+    static const uint8_t bufferSize = 72;
+
+    static const uint8_t numCoils = 8;
+    static const uint8_t numDiscreteInputs = 12;
+    static const uint8_t REG_NUMBER = 0;
+    static const uint8_t REG_BCD = 1;
+    static const uint8_t REG_COLON = 2;
+    static const uint8_t REG_BRIGHTNESS = 3;
+    static const uint8_t REG_TIMER_TIMEOUT = 16;
+    static const uint8_t REG_TIMER_REMAINING = 24;
+
+    IO22ModbusRTU(IO22D08Base &board, IO22RelayTimers *timers = nullptr) :
+      _board(board), _timers(timers) {}
+
+    // address: 1-247; driverEnablePin: RS485 DE (high while transmitting),
+    // or noDriverEnable
+    void begin(uint32_t baud, uint8_t address, uint8_t driverEnablePin = noDriverEnable,
+      uint8_t parity = PARITY_EVEN);
+    void end();
+
+    // serve a received request, if there is one; call from loop()
+    // - true when a request addressed to this slave (or a broadcast) was
+    //   served
+    bool poll();
+
+    // counters for diagnostics: requests served, frames dropped (CRC, UART
+    // errors, overrun), exception responses sent
+    uint16_t requests() { return _requests; }
+    uint16_t errors() { return _errors; }
+    uint16_t exceptions() { return _exceptions; }
+
+    // USART0/Timer1 ISR hooks; not for use by sketches
+    // - _vectors(): defined by IO22_MODBUS_RTU_ISRS(), i.e. null unless the
+    //   sketch has the vectors
+    static void _vectors() __attribute__((weak));
+    static void _isrReceive();
+    static void _isrFrameEnd();
+    static void _isrTransmit();
+    static void _isrTransmitComplete();
+
+  protected:
+    static const uint8_t STATE_RECEIVING = 0;
+    static const uint8_t STATE_FRAME = 1;     // complete frame waiting for poll()
+    static const uint8_t STATE_SENDING = 2;
+
+    IO22D08Base &_board;
+    IO22RelayTimers *_timers;
+    uint8_t _address = 0;
+    uint16_t _number = 0;
+    uint16_t _bcd = 0;
+    uint16_t _requests = 0;
+    uint16_t _errors = 0;
+    uint16_t _exceptions = 0;
+
+    // the frame being received or sent; one slave per UART, so static
+    static uint8_t _buffer[bufferSize];
+    static volatile uint8_t _length;
+    static volatile uint8_t _sent;
+    static volatile uint8_t _state;
+    static volatile bool _frameError;
+    static volatile uint16_t _crc;
+    static uint16_t _silenceCycles;           // 3.5 characters, Timer1 cycles
+    static uint8_t _driverEnablePin;
+
+    static uint16_t _word(uint8_t i) { return ((uint16_t)_buffer[i] << 8) | _buffer[i+1]; }
+    static void _putWord(uint8_t i, uint16_t w) { _buffer[i] = highByte(w); _buffer[i+1] = lowByte(w); }
+
+    // - each returns the response length without the CRC, 0 for no response
+    //   (e.g. broadcast), or an exception code (as -code)
+    int8_t _serve(bool broadcast);
+    int8_t _readBits(uint16_t start, uint16_t count, uint16_t limit, bool coils);
+    int8_t _readRegisters(uint16_t start, uint16_t count);
+    bool _readRegister(uint16_t reg, uint16_t &value);
+    bool _writeRegister(uint16_t reg, uint16_t value);
+    void _respond(uint8_t length);
+    static void _receiveNext();
+};
+
+// the vectors (see above); at file scope, in the one sketch using the slave
+#ifdef IO22D08_AVR_M328
+#define IO22_MODBUS_RTU_ISRS() \
+  ISR(USART_RX_vect) \
+  { \
+    IO22_PROFILE_ISR_SCOPE(IO22Profiler::PROBE_MODBUS_ISR); \
+    IO22ModbusRTU::_isrReceive(); \
+  } \
+  ISR(TIMER1_COMPB_vect) \
+  { \
+    IO22ModbusRTU::_isrFrameEnd(); \
+  } \
+  ISR(USART_UDRE_vect) \
+  { \
+    IO22_PROFILE_ISR_SCOPE(IO22Profiler::PROBE_MODBUS_ISR); \
+    IO22ModbusRTU::_isrTransmit(); \
+  } \
+  ISR(USART_TX_vect) \
+  { \
+    IO22ModbusRTU::_isrTransmitComplete(); \
+  } \
+  void IO22ModbusRTU::_vectors() {}
+#else
+#define IO22_MODBUS_RTU_ISRS()
+#endif
+
+#endif
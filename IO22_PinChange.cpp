@@ -0,0 +1,195 @@
+/*
+  pin change pulse counting for the IO22D08 inputs
+
+  - a pin change interrupt only says that one (or more) of the enabled pins in
+    the group has changed, not which one or in what direction: the ISR keeps
+    a snapshot of the port and XORs it with the current pins to find the
+    changed pins, then masks those with the current level to separate the
+    rising from the falling edges
+  - the pins are read once, at the top of the ISR: a pin that changes again
+    between the interrupt and the read is seen as no change (i.e. a pulse
+    shorter than the ISR latency, a few us, can be lost); that's well beyond
+    what the optocoupled inputs will pass
+  - the input -> (group, bit) mapping is fixed by the board; each group's ISR
+    passes a constant group number so the dispatch below folds down to a few
+    bit tests
+*/
+
+#include "Arduino.h"
+#include "IO22_PinChange.h"
+
+volatile uint16_t IO22PinChange::_counts[IO22D08Traits::numInputs];
+uint8_t IO22PinChange::_previous[3];
+uint8_t IO22PinChange::_rising[3];
+uint8_t IO22PinChange::_falling[3];
+uint8_t IO22PinChange::_wake[3];
+volatile bool IO22PinChange::_woken = false;
+volatile uint32_t IO22PinChange::_wakeMicros = 0;
+
+#ifdef IO22D08_AVR_M328
+
+// pin change group and port bit, per input
+// - IN1-IN5 = PD2-PD6, IN6 = PC0, IN7 = PB4, IN8 = PB3
+static const uint8_t _pinGroup[IO22D08Traits::numInputs] = {2, 2, 2, 2, 2, 1, 0, 0};
+static const uint8_t _pinBit[IO22D08Traits::numInputs] = {2, 3, 4, 5, 6, 0, 4, 3};
+// the wake pins per group: IN7/IN8, K2-K4 = PB3/PB4, PB0-PB2; IN6 = PC0;
+// IN1-IN5, K1 = PD2-PD7
+static const uint8_t _wakePins[3] = {0x1F, 0x01, 0xFC};
+
+static volatile uint8_t *_pcmsk(uint8_t group)
+{
+  return group == 0 ? &PCMSK0 : group == 1 ? &PCMSK1 : &PCMSK2;
+}
+
+static uint8_t _pins(uint8_t group)
+{
+  return group == 0 ? PINB : group == 1 ? PINC : PIND;
+}
+
+inline __attribute__((always_inline)) void IO22PinChange::_isrGroup(uint8_t group, uint8_t pins)
+{
+  uint8_t changed = pins ^ _previous[group];
+  _previous[group] = pins;
+  if ((changed & _wake[group]) && !_woken)
+  {
+    _wakeMicros = micros();
+    _woken = true;
+  }
+  uint8_t edges = (changed & pins & _rising[group]) | (changed & ~pins & _falling[group]);
+  if (!edges) return;
+  switch (group)
+  {
+    case 0:
+      if (edges & _BV(4)) _counts[6]++;
+      if (edges & _BV(3)) _counts[7]++;
+      break;
+    case 1:
+      if (edges & _BV(0)) _counts[5]++;
+      break;
+    case 2:
+      if (edges & _BV(2)) _counts[0]++;
+      if (edges & _BV(3)) _counts[1]++;
+      if (edges & _BV(4)) _counts[2]++;
+      if (edges & _BV(5)) _counts[3]++;
+      if (edges & _BV(6)) _counts[4]++;
+      break;
+  }
+}
+
+// the PCINT vectors' bodies (IO22_PIN_CHANGE_ISRS())
+void IO22PinChange::_isrGroup0()
+{
+  _isrGroup(0, PINB);
+}
+
+void IO22PinChange::_isrGroup1()
+{
+  _isrGroup(1, PINC);
+}
+
+void IO22PinChange::_isrGroup2()
+{
+  _isrGroup(2, PIND);
+}
+
+// - without the vectors (IO22_PIN_CHANGE_ISRS()) the interrupts enabled below
+//   would reset the board: fail instead
+bool IO22PinChange::enable(uint8_t input, uint8_t edge)
+{
+  if (input < 1 || input > IO22D08Traits::numInputs || !_vectors) return false;
+  uint8_t g = _pinGroup[input-1];
+  uint8_t m = _BV(_pinBit[input-1]);
+  IO22InterruptLock lock;
+  // snapshot the pin before unmasking it, so enabling isn't seen as an edge
+  _previous[g] = (_previous[g] & ~m) | (_pins(g) & m);
+  if (edge == RISING || edge == CHANGE) _rising[g] |= m; else _rising[g] &= ~m;
+  if (edge == FALLING || edge == CHANGE) _falling[g] |= m; else _falling[g] &= ~m;
+  *_pcmsk(g) |= m;
+  PCICR |= _BV(g);
+  return true;
+}
+
+void IO22PinChange::disable(uint8_t input)
+{
+  if (input < 1 || input > IO22D08Traits::numInputs) return;
+  uint8_t g = _pinGroup[input-1];
+  uint8_t m = _BV(_pinBit[input-1]);
+  IO22InterruptLock lock;
+  _rising[g] &= ~m;
+  _falling[g] &= ~m;
+  volatile uint8_t *pcmsk = _pcmsk(g);
+  *pcmsk &= ~m;
+  if (!*pcmsk) PCICR &= ~_BV(g);
+}
+
+bool IO22PinChange::armWake()
+{
+  if (!_vectors) return false;
+  IO22InterruptLock lock;
+  _woken = false;
+  for (uint8_t g = 0; g < 3; g++)
+  {
+    uint8_t m = _wakePins[g];
+    _previous[g] = (_previous[g] & ~m) | (_pins(g) & m);
+    _wake[g] = m;
+    *_pcmsk(g) |= m;
+    PCICR |= _BV(g);
+  }
+  return true;
+}
+
+void IO22PinChange::disarmWake()
+{
+  IO22InterruptLock lock;
+  for (uint8_t g = 0; g < 3; g++)
+  {
+    _wake[g] = 0;
+    volatile uint8_t *pcmsk = _pcmsk(g);
+    *pcmsk &= _rising[g] | _falling[g];
+    if (!*pcmsk) PCICR &= ~_BV(g);
+  }
+}
+
+#else
+
+bool IO22PinChange::enable(uint8_t, uint8_t)
+{
+  return false;
+}
+
+void IO22PinChange::disable(uint8_t)
+{
+}
+
+bool IO22PinChange::armWake()
+{
+  return false;
+}
+
+void IO22PinChange::disarmWake()
+{
+}
+
+#endif
+
+uint16_t IO22PinChange::count(uint8_t input)
+{
+  if (input < 1 || input > IO22D08Traits::numInputs) return 0;
+  IO22InterruptLock lock;
+  return _counts[input-1];
+}
+
+uint16_t IO22PinChange::takeCount(uint8_t input)
+{
+  if (input < 1 || input > IO22D08Traits::numInputs) return 0;
+  IO22InterruptLock lock;
+  uint16_t c = _counts[input-1];
+  _counts[input-1] = 0;
+  return c;
+}
+
+uint32_t IO22PinChange::wakeMicros()
+{
+  IO22InterruptLock lock;
+  return _wakeMicros;
+}
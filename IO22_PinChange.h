@@ -0,0 +1,92 @@
+#ifndef IO22_PinChange_h
+
+#define IO22_PinChange_h
+
+#include "Arduino.h"
+#include "IO22_IO_Board.h"
+
+// pulse counting on the inputs via the pin change interrupts (flow meters,
+// tachometers, ...)
+// - the inputs are spread over all three pin change groups: IN1-IN5 are
+//   PD2-PD6 (PCINT2), IN6 is PC0 (PCINT1), IN7/IN8 are PB4/PB3 (PCINT0)
+// - one ISR per group: the port is XOR'ed with the previous snapshot to find
+//   the edges, which are then counted per input; the ISR cost is per edge,
+//   not per enabled input
+// - counters are 16 bits (to keep the ISR and reads cheap): read them at
+//   least every 65535 pulses, or use takeCount() and accumulate
+// - IN1/IN2 are better served by IO22FrequencyInput (external interrupts,
+//   timestamped edges); they're counted here as well for completeness
+// - uses the PCINT vectors directly; they're opt-in, so only the sketch
+//   counting pulses (or sleeping with IO22Power) gives them up: expand
+//   IO22_PIN_CHANGE_ISRS() once in that sketch (which then can't use
+//   SoftwareSerial or other pin change interrupt libraries); enable() and
+//   armWake() fail without them
+// - ATmega328P only; elsewhere enable() returns false
+class IO22PinChange
+{
+  public:
+    // - input: 1-8 (IN1-IN8)
+    // - edge: FALLING (input becoming active; the inputs are active low),
+    //   RISING (input released) or CHANGE (both)
+    static bool enable(uint8_t input, uint8_t edge = FALLING);
+    static void disable(uint8_t input);
+
+    static uint16_t count(uint8_t input);
+    // read and clear the count, atomically
+    static uint16_t takeCount(uint8_t input);
+    static void clear(uint8_t input) { takeCount(input); }
+
+    // wake-up source for IO22Power: any change on IN1-IN8 or K1-K4 sets
+    // woken() and timestamps the change (micros(), from the ISR)
+    // - armWake() snapshots the pins first, so only changes after arming count
+    // - independent of the counting: the wake pins don't count edges, and
+    //   disarmWake() leaves the counting pins enabled
+    // - false without the vectors: nothing would wake the board
+    static bool armWake();
+    static void disarmWake();
+    static bool woken() { return _woken; }
+    static uint32_t wakeMicros();
+
+    // PCINT ISR hooks; not for use by sketches
+    // - _vectors(): defined by IO22_PIN_CHANGE_ISRS(), i.e. null unless the
+    //   sketch has the vectors
+    static void _isrGroup0();
+    static void _isrGroup1();
+    static void _isrGroup2();
+    static void _vectors() __attribute__((weak));
+
+  protected:
+    static void _isrGroup(uint8_t group, uint8_t pins);
+    static volatile uint16_t _counts[IO22D08Traits::numInputs];
+    static uint8_t _previous[3];        // port snapshot, per group
+    static uint8_t _rising[3];          // pins counting rising edges
+    static uint8_t _falling[3];         // pins counting falling edges
+    static uint8_t _wake[3];            // pins armed for wake-up
+    static volatile bool _woken;
+    static volatile uint32_t _wakeMicros;
+};
+
+// the vectors (see above); at file scope, in the one sketch using them
+#ifdef IO22D08_AVR_M328
+#define IO22_PIN_CHANGE_ISRS() \
+  ISR(PCINT0_vect) \
+  { \
+    IO22_PROFILE_ISR_SCOPE(IO22Profiler::PROBE_PINCHANGE_ISR); \
+    IO22PinChange::_isrGroup0(); \
+  } \
+  ISR(PCINT1_vect) \
+  { \
+    IO22_PROFILE_ISR_SCOPE(IO22Profiler::PROBE_PINCHANGE_ISR); \
+    IO22PinChange::_isrGroup1(); \
+  } \
+  ISR(PCINT2_vect) \
+  { \
+    IO22_PROFILE_ISR_SCOPE(IO22Profiler::PROBE_PINCHANGE_ISR); \
+    IO22PinChange::_isrGroup2(); \
+  } \
+  void IO22PinChange::_vectors() {}
+#else
+#define IO22_PIN_CHANGE_ISRS()
+#endif
+
+#endif
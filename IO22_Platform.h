@@ -0,0 +1,95 @@
+#ifndef IO22_Platform_h
+
+#define IO22_Platform_h
+
+#include "Arduino.h"
+#ifdef __AVR__
+#include <util/crc16.h>
+#endif
+
+// platform detection and the interrupt lock, shared by all the IO22 modules
+
+// the Pro Mini's ATmega328P (and its 168 sibling) get the hardware specific
+// fast paths:
+// - the Timer2-driven background refresh; elsewhere refreshDisplayAndRelays()
+//   has to be called from loop()
+// - direct port register access for the shift registers instead of
+//   digitalWrite()/shiftOut(); define IO22D08_NO_FAST_SHIFT to opt out
+#if defined(__AVR_ATmega328P__) || defined(__AVR_ATmega328__) || defined(__AVR_ATmega168__)
+#define IO22D08_AVR_M328 1
+#define IO22D08_AUTO_REFRESH 1
+#ifndef IO22D08_NO_FAST_SHIFT
+#define IO22D08_FAST_SHIFT 1
+#endif
+#endif
+
+// interrupt lock for the (short) critical sections shared with ISRs: restores
+// the prior interrupt state on leaving scope
+// - used only around byte/word sized updates; never across a frame
+// - AVR: SREG is saved and restored; Cortex-M: PRIMASK likewise
+// - elsewhere there's no portable way to read the interrupt state, so nested
+//   locks are counted and only the outermost one re-enables interrupts; such
+//   a lock mustn't be taken where interrupts are off for other reasons (e.g.
+//   in an ISR), as leaving it would enable them
+class IO22InterruptLock
+{
+  public:
+#if defined(__AVR__)
+    IO22InterruptLock() : _sreg(SREG) { cli(); }
+    ~IO22InterruptLock() { SREG = _sreg; }
+  protected:
+    uint8_t _sreg;
+#elif defined(__arm__) && defined(__ARM_ARCH_PROFILE) && __ARM_ARCH_PROFILE == 'M'
+    IO22InterruptLock()
+    {
+      __asm__ __volatile__("mrs %0, primask" : "=r" (_primask));
+      __asm__ __volatile__("cpsid i" ::: "memory");
+    }
+    ~IO22InterruptLock() { __asm__ __volatile__("msr primask, %0" :: "r" (_primask) : "memory"); }
+  protected:
+    uint32_t _primask;
+#else
+    IO22InterruptLock()
+    {
+      noInterrupts();
+      _depth()++;
+    }
+    ~IO22InterruptLock()
+    {
+      if (!--_depth()) interrupts();
+    }
+  protected:
+    // one count for the program (an inline function's static)
+    static uint8_t &_depth()
+    {
+      static uint8_t depth = 0;
+      return depth;
+    }
+#endif
+};
+
+// CRC-16/MODBUS (reflected polynomial 0xA001, from 0xFFFF): the Modbus RTU
+// frame check, also used for the EEPROM config slots
+class IO22Crc16
+{
+  public:
+    static const uint16_t initial = 0xFFFF;
+    static uint16_t update(uint16_t crc, uint8_t b)
+    {
+#ifdef __AVR__
+      return _crc16_update(crc, b);
+#else
+      crc ^= b;
+      for (uint8_t i = 0; i < 8; i++) crc = (crc & 1) ? (crc >> 1) ^ 0xA001 : crc >> 1;
+      return crc;
+#endif
+    }
+    static uint16_t update(uint16_t crc, const void *data, uint8_t size)
+    {
+      const uint8_t *p = static_cast<const uint8_t *>(data);
+      while (size--) crc = update(crc, *p++);
+      return crc;
+    }
+};
+
+#endif
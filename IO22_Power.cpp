@@ -0,0 +1,70 @@
+/*
+  sleep modes for the IO22 boards
+
+  - going to sleep has to be race-free: an input change between arming the
+    wake-up and the sleep instruction would otherwise be missed and the board
+    sleep through it; interrupts are disabled while checking the woken flag,
+    and re-enabled (sei) immediately before sleep_cpu(), which the AVR
+    guarantees executes before any pending interrupt is taken
+  - a wake-up that isn't the input change (e.g. the millis() timer in idle)
+    goes straight back to sleep
+*/
+
+#include "Arduino.h"
+#include "IO22_Power.h"
+
+#ifdef IO22D08_AVR_M328
+#include <avr/sleep.h>
+#endif
+
+bool IO22Power::_actionPending = false;
+uint32_t IO22Power::_latency = 0;
+uint16_t IO22Power::_wakeCount = 0;
+
+#ifdef IO22D08_AVR_M328
+
+// - without the pin change vectors there's no waking up: don't sleep
+void IO22Power::sleepUntilWake(uint8_t mode)
+{
+  if (!IO22PinChange::armWake()) return;
+  uint8_t adcsra = ADCSRA;
+  if (mode == SLEEP_POWER_DOWN)
+  {
+    ADCSRA = adcsra & ~_BV(ADEN);
+    set_sleep_mode(SLEEP_MODE_PWR_DOWN);
+  }
+  else
+    set_sleep_mode(SLEEP_MODE_IDLE);
+  for (;;)
+  {
+    cli();
+    if (IO22PinChange::woken()) break;
+    sleep_enable();
+#if defined(BODS) && defined(BODSE)
+    if (mode == SLEEP_POWER_DOWN) sleep_bod_disable();
+#endif
+    sei();
+    sleep_cpu();
+    sleep_disable();
+  }
+  sei();
+  ADCSRA = adcsra;
+  IO22PinChange::disarmWake();
+  _actionPending = true;
+  _wakeCount++;
+}
+
+#else
+
+void IO22Power::sleepUntilWake(uint8_t)
+{
+}
+
+#endif
+
+void IO22Power::markAction()
+{
+  if (!_actionPending) return;
+  _actionPending = false;
+  _latency = micros() - IO22PinChange::wakeMicros();
+}
@@ -0,0 +1,64 @@
+#ifndef IO22_Power_h
+
+#define IO22_Power_h
+
+#include "Arduino.h"
+#include "IO22_IO_Board.h"
+#include "IO22_PinChange.h"
+
+// sleeping between input changes: the board's display is blanked and its
+// refresh stopped (IO22Board::enterLowPower()), the relays stay latched and
+// enabled, and the CPU sleeps until any of IN1-IN8 or K1-K4 changes (pin
+// change interrupts, IO22PinChange::armWake())
+// - SLEEP_IDLE: only the CPU stops; millis()/micros(), Serial and any other
+//   timers carry on, wake-up is immediate
+// - SLEEP_POWER_DOWN: the oscillator stops as well (and the ADC and, where
+//   the chip has it, the brown-out detector are off for the duration);
+//   millis()/micros() stand still while asleep, so timeouts (IO22RelayTimers
+//   included) are stretched by the time spent asleep: use SLEEP_IDLE while
+//   any are running
+// - flush Serial before sleeping in power-down: a character being sent is
+//   cut off
+// - an input that's already active when going to sleep doesn't wake it (it's
+//   the change that does); check the inputs first
+// - wake latency: from the waking change (timestamped by the pin change ISR)
+//   to the sketch's markAction() once it's latched the relay action, via
+//   micros() (4us resolution); the oscillator start-up after power-down
+//   (16K clocks, ~1ms at 16MHz, with the Pro Mini's fuses) comes before the
+//   ISR can run, so isn't in the figure
+// - needs the pin change vectors: expand IO22_PIN_CHANGE_ISRS() once in the
+//   sketch; without them sleep() returns straight away
+// - IO22D08 (its IN/K wiring), ATmega328P only; elsewhere sleep() returns
+//   straight away
+class IO22Power
+{
+  public:
+    static const uint8_t SLEEP_IDLE = 0;
+    static const uint8_t SLEEP_POWER_DOWN = 1;
+
+    // low power, sleep until woken, then restore the display/refresh
+    template <class Board>
+    static void sleep(Board &board, uint8_t mode = SLEEP_POWER_DOWN)
+    {
+      board.enterLowPower();
+      sleepUntilWake(mode);
+      board.exitLowPower();
+    }
+    // sleep only: the display/refresh are left to the caller
+    static void sleepUntilWake(uint8_t mode = SLEEP_POWER_DOWN);
+
+    // the wake-up's action has taken effect: record the latency (once per
+    // wake-up; later calls are ignored)
+    static void markAction();
+    // us from the waking input change to markAction(), for the last wake-up;
+    // 0 if there hasn't been one
+    static uint32_t wakeLatency() { return _latency; }
+    static uint16_t wakeCount() { return _wakeCount; }
+
+  protected:
+    static bool _actionPending;
+    static uint32_t _latency;
+    static uint16_t _wakeCount;
+};
+
+#endif
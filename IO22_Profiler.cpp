@@ -0,0 +1,96 @@
+/*
+  hot path profiler for the IO22D08 library
+
+  - the running sum is 32 bits of cycles (~268s) and the count 16 bits: when
+    either is about to overflow both are halved, which keeps the average (to
+    within a cycle) without having to reset
+  - the probe names are in flash; report() is for on demand use (it prints a
+    few hundred characters, blocking), not for every pass of loop()
+*/
+
+#include "Arduino.h"
+#include "IO22_Profiler.h"
+
+IO22Profiler::Stats IO22Profiler::_stats[IO22Profiler::numProbes];
+uint32_t IO22Profiler::_previousLoop = 0;
+
+static const char _name0[] PROGMEM = "loop";
+static const char _name1[] PROGMEM = "refresh";
+static const char _name2[] PROGMEM = "refreshStep";
+static const char _name3[] PROGMEM = "scanInputs";
+static const char _name4[] PROGMEM = "timers";
+static const char _name5[] PROGMEM = "refresh ISR";
+static const char _name6[] PROGMEM = "frequency ISR";
+static const char _name7[] PROGMEM = "pin change ISR";
+static const char _name8[] PROGMEM = "modbus";
+static const char _name9[] PROGMEM = "modbus ISR";
+static const char * const _probeNames[IO22Profiler::numProbes] PROGMEM = {
+  _name0, _name1, _name2, _name3, _name4, _name5, _name6, _name7,
+  _name8, _name9
+};
+
+void IO22Profiler::accumulate(Stats &s, uint32_t sample)
+{
+  if (!s.count)
+  {
+    s.min = s.max = s.sum = sample;
+    s.count = 1;
+    return;
+  }
+  if (sample < s.min) s.min = sample;
+  if (sample > s.max) s.max = sample;
+  if (s.count == 0xFFFF || s.sum + sample < s.sum)
+  {
+    s.sum >>= 1;
+    s.count >>= 1;
+  }
+  s.sum += sample;
+  s.count++;
+}
+
+void IO22Profiler::markLoop()
+{
+  uint32_t now = IO22Clock::now();
+  if (_previousLoop) record(PROBE_LOOP, now - _previousLoop);
+  _previousLoop = now;
+}
+
+bool IO22Profiler::read(uint8_t probe, Stats &stats)
+{
+  if (probe >= numProbes) return false;
+  IO22InterruptLock lock;
+  stats = _stats[probe];
+  return stats.count;
+}
+
+void IO22Profiler::reset()
+{
+  IO22InterruptLock lock;
+  for (uint8_t p = 0; p < numProbes; p++) _stats[p].count = 0;
+  _previousLoop = 0;
+}
+
+static void _printMicros(Print &out, uint32_t cycles)
+{
+  out.print((float)cycles / IO22Clock::cyclesPerMicrosecond, 1);
+}
+
+void IO22Profiler::report(Print &out, bool resetAfter)
+{
+  for (uint8_t p = 0; p < numProbes; p++)
+  {
+    Stats s;
+    if (!read(p, s)) continue;
+    out.print((const __FlashStringHelper *)pgm_read_ptr(&_probeNames[p]));
+    out.print(F(": n="));
+    out.print(s.count);
+    out.print(F(" min="));
+    _printMicros(out, s.min);
+    out.print(F(" avg="));
+    _printMicros(out, s.sum / s.count);
+    out.print(F(" max="));
+    _printMicros(out, s.max);
+    out.println(F("us"));
+  }
+  if (resetAfter) reset();
+}
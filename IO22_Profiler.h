@@ -0,0 +1,109 @@
+#ifndef IO22_Profiler_h
+
+#define IO22_Profiler_h
+
+#include "Arduino.h"
+#include "IO22_Clock.h"
+
+// hot path profiling: min/max/average durations, in IO22Clock cycles (62.5ns),
+// of the library's refresh, scan and timer paths, the ISR bodies and the
+// sketch's loop() period
+// - define IO22_PROFILE to enable; without it the IO22_PROFILE_* macros
+//   compile to nothing
+//   - the profiler's storage (_stats, 14 bytes per probe) and functions are
+//     compiled into the library either way: a sketch defining IO22_PROFILE
+//     links to them, and IO22TaskScheduler uses accumulate(); a sketch that
+//     references none of them only loses them to the Arduino build's
+//     --gc-sections
+//   - IO22_PROFILE has to be defined for the whole build (e.g. via build
+//     flags) to instrument the library's .cpp files; defining it in the
+//     sketch only instruments the sketch and the header-defined refresh paths
+// - uses IO22Clock, i.e. takes over Timer1; IO22_PROFILE_BEGIN() starts it,
+//   and the sketch expands IO22_CLOCK_ISRS()
+// - each probe is updated from one context only (loop() or its ISR), so the
+//   updates need no locking; report() copies each probe atomically
+// - the ISR probes time the ISR body, not the compiler's prologue/epilogue
+//   (a few dozen cycles more)
+// - SRAM footprint: 14 bytes per probe
+class IO22Profiler
+{
+  public:
+    static const uint8_t PROBE_LOOP = 0;            // loop() period
+    static const uint8_t PROBE_REFRESH = 1;         // refreshDisplayAndRelays()
+    static const uint8_t PROBE_REFRESH_STEP = 2;    // refreshStep()
+    static const uint8_t PROBE_SCAN = 3;            // scanInputs()
+    static const uint8_t PROBE_TIMERS = 4;          // IO22RelayTimers::tick()
+    static const uint8_t PROBE_REFRESH_ISR = 5;     // Timer2 auto refresh
+    static const uint8_t PROBE_FREQUENCY_ISR = 6;   // INT0/INT1 (IO22FrequencyInput)
+    static const uint8_t PROBE_PINCHANGE_ISR = 7;   // PCINT0-2 (IO22PinChange)
+    static const uint8_t PROBE_MODBUS = 8;          // IO22ModbusRTU::poll(), serving a request
+    static const uint8_t PROBE_MODBUS_ISR = 9;      // USART0/Timer1 COMPB (IO22ModbusRTU)
+    static const uint8_t numProbes = 10;
+
+    struct Stats
+    {
+      uint32_t min;
+      uint32_t max;
+      uint32_t sum;
+      uint16_t count;
+    };
+
+    // false without the clock's vector (IO22_CLOCK_ISRS())
+    static bool begin() { return IO22Clock::begin(); }
+
+    static void record(uint8_t probe, uint32_t cycles) { accumulate(_stats[probe], cycles); }
+    // add a sample to a set of stats (e.g. of its own, see IO22TaskScheduler)
+    static void accumulate(Stats &stats, uint32_t sample);
+    // loop() period: cycles since the previous call
+    static void markLoop();
+
+    // atomic copy of a probe's stats; false if nothing has been recorded
+    static bool read(uint8_t probe, Stats &stats);
+    static void reset();
+    // one line per probe: name, count, min/avg/max in us; blocking
+    static void report(Print &out, bool resetAfter = true);
+
+  protected:
+    static Stats _stats[numProbes];
+    static uint32_t _previousLoop;
+};
+
+// times the enclosing scope
+class IO22ProfileScope
+{
+  public:
+    IO22ProfileScope(uint8_t probe) : _probe(probe), _start(IO22Clock::now()) {}
+    ~IO22ProfileScope() { IO22Profiler::record(_probe, IO22Clock::now() - _start); }
+
+  protected:
+    uint8_t _probe;
+    uint32_t _start;
+};
+
+// as IO22ProfileScope, for ISRs (interrupts already disabled)
+class IO22ProfileISRScope
+{
+  public:
+    IO22ProfileISRScope(uint8_t probe) : _probe(probe), _start(IO22Clock::nowFromISR()) {}
+    ~IO22ProfileISRScope() { IO22Profiler::record(_probe, IO22Clock::nowFromISR() - _start); }
+
+  protected:
+    uint8_t _probe;
+    uint32_t _start;
+};
+
+#ifdef IO22_PROFILE
+#define IO22_PROFILE_BEGIN() IO22Profiler::begin()
+#define IO22_PROFILE_SCOPE(probe) IO22ProfileScope _io22ProfileScope(probe)
+#define IO22_PROFILE_ISR_SCOPE(probe) IO22ProfileISRScope _io22ProfileScope(probe)
+#define IO22_PROFILE_LOOP() IO22Profiler::markLoop()
+#define IO22_PROFILE_REPORT(out) IO22Profiler::report(out)
+#else
+#define IO22_PROFILE_BEGIN()
+#define IO22_PROFILE_SCOPE(probe)
+#define IO22_PROFILE_ISR_SCOPE(probe)
+#define IO22_PROFILE_LOOP()
+#define IO22_PROFILE_REPORT(out)
+#endif
+
+#endif
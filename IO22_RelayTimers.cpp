@@ -0,0 +1,102 @@
+/*
+  relay timers for the IO22D08
+
+  - replaces polling every timer (and calling millis()) in each pass of
+    loop() with a deadline queue: a handful of running timers means the queue
+    is tiny, so it is kept sorted with a simple insertion on start()
+  - deadlines are compared as (signed) differences so millis() roll over
+    (every ~49 days) is handled
+*/
+
+#include "Arduino.h"
+#include "IO22_RelayTimers.h"
+
+void IO22RelayTimers::setTimeout(uint8_t id, uint8_t relayMask, uint16_t seconds)
+{
+  if (id >= maxTimers) return;
+  _timers[id].relayMask = relayMask;
+  _timers[id].timeout = seconds * 1000UL;
+}
+
+// position of the given timer in the queue, -1 if not running
+int8_t IO22RelayTimers::_find(uint8_t id)
+{
+  for (uint8_t p = 0; p < _queued; p++)
+    if (_queue[p] == id) return p;
+  return -1;
+}
+
+void IO22RelayTimers::_remove(uint8_t pos)
+{
+  _queued--;
+  for (uint8_t p = pos; p < _queued; p++) _queue[p] = _queue[p+1];
+}
+
+bool IO22RelayTimers::isActive(uint8_t id)
+{
+  return _find(id) >= 0;
+}
+
+void IO22RelayTimers::start(uint8_t id)
+{
+  if (id >= maxTimers || !_timers[id].relayMask) return;
+  int8_t pos = _find(id);
+  if (pos >= 0) _remove(pos);  // restart
+
+  uint32_t deadline = millis() + _timers[id].timeout;
+  _timers[id].deadline = deadline;
+  // insert behind any timers due at or before this one
+  uint8_t p = _queued;
+  while (p > 0 && (int32_t)(deadline - _timers[_queue[p-1]].deadline) < 0)
+  {
+    _queue[p] = _queue[p-1];
+    p--;
+  }
+  _queue[p] = id;
+  _queued++;
+
+  _board.relaySet(_timers[id].relayMask, IO22D08Base::RELAY_ON);
+}
+
+void IO22RelayTimers::stop(uint8_t id)
+{
+  int8_t pos = _find(id);
+  if (pos < 0) return;
+  _remove(pos);
+  _board.relaySet(_timers[id].relayMask, IO22D08Base::RELAY_OFF);
+}
+
+uint8_t IO22RelayTimers::tick()
+{
+  IO22_PROFILE_SCOPE(IO22Profiler::PROBE_TIMERS);
+  if (!_queued) return 0;
+  uint32_t now = millis();
+  uint8_t expired = 0;
+  uint8_t n = 0;
+  while (n < _queued && (int32_t)(now - _timers[_queue[n]].deadline) >= 0)
+    expired |= _timers[_queue[n++]].relayMask;
+  if (!n) return 0;
+  // drop the expired timers off the head of the queue
+  _queued -= n;
+  for (uint8_t p = 0; p < _queued; p++) _queue[p] = _queue[p+n];
+  _board.relaySet(expired, IO22D08Base::RELAY_OFF);
+  return expired;
+}
+
+uint32_t IO22RelayTimers::_remaining(uint8_t id, uint32_t now)
+{
+  int32_t r = _timers[id].deadline - now;
+  return r > 0 ? r : 0;
+}
+
+uint32_t IO22RelayTimers::timeRemaining(uint8_t id)
+{
+  if (!isActive(id)) return noDeadline;
+  return _remaining(id, millis());
+}
+
+uint32_t IO22RelayTimers::nextTimeRemaining()
+{
+  if (!_queued) return noDeadline;
+  return _remaining(_queue[0], millis());
+}
@@ -0,0 +1,63 @@
+#ifndef IO22_RelayTimers_h
+
+#define IO22_RelayTimers_h
+
+#include "Arduino.h"
+#include "IO22_IO_Board.h"
+
+class IO22RelayTimers
+{
+  // a set of relay timers: start() turns a timer's relay(s) on, and once its
+  // timeout has elapsed tick() turns them off again
+  // - relay masks are used to allow multiple relays to be switched together
+  // - the running timers are kept in a queue sorted by deadline: tick() reads
+  //   millis() once and only has to look at the head of the queue, every
+  //   timer that has expired is switched off in a single relaySet()
+  // - the next deadline (e.g. for display) is simply the head of the queue
+  // - timer IDs are 0..maxTimers-1
+
+  public:
+    static const uint8_t maxTimers = 8;
+    static const uint32_t noDeadline = 0xFFFFFFFF;  // no timer running
+
+    IO22RelayTimers(IO22D08Base &board) : _board(board) {}
+
+    // relay mask and timeout (seconds) for the given timer
+    void setTimeout(uint8_t id, uint8_t relayMask, uint16_t seconds);
+    uint8_t relayMask(uint8_t id) { return _timers[id].relayMask; }
+    uint16_t timeout(uint8_t id) { return _timers[id].timeout / 1000; }
+
+    // (re)start a timer: its relays are turned on now and off once the
+    // timeout has elapsed; a timer without any relays is a no-op
+    void start(uint8_t id);
+    // stop a timer, turning its relays off
+    void stop(uint8_t id);
+    bool isActive(uint8_t id);
+
+    // switch off any expired timers; returns the mask of relays switched off
+    uint8_t tick();
+
+    // ms until the given timer / the next timer to expire (noDeadline if
+    // not running / none running)
+    uint32_t timeRemaining(uint8_t id);
+    uint32_t nextTimeRemaining();
+
+  protected:
+    struct Timer
+    {
+      uint32_t timeout;   // ms
+      uint32_t deadline;  // millis() at expiry
+      uint8_t relayMask;
+    };
+
+    IO22D08Base &_board;
+    Timer _timers[maxTimers] = {};
+    uint8_t _queue[maxTimers];  // IDs of the running timers, soonest first
+    uint8_t _queued = 0;
+
+    int8_t _find(uint8_t id);
+    void _remove(uint8_t pos);
+    uint32_t _remaining(uint8_t id, uint32_t now);
+};
+
+#endif
@@ -0,0 +1,48 @@
+/*
+  display sequences for the IO22 boards
+
+  - the frames are copied in whole when added; playing only ever moves the
+    _shown pointer, which the refresh reads once per digit frame
+*/
+
+#include "Arduino.h"
+#include "IO22_Sequencer.h"
+
+bool IO22DisplaySequence::add(const uint16_t *digits, uint16_t cycles)
+{
+  if (isFull()) return false;
+  Frame &f = _frames[_count++];
+  memcpy(f.digits, digits, sizeof(f.digits));
+  f.cycles = cycles ? cycles : 1;
+  return true;
+}
+
+bool IO22DisplaySequence::_start()
+{
+  if (!_count) return false;
+  _index = 0;
+  _cyclesLeft = _frames[0].cycles;
+  _shown = _frames[0].digits;
+  _finished = false;
+  return true;
+}
+
+bool IO22DisplaySequence::_tick()
+{
+  if (--_cyclesLeft) return false;
+  uint8_t i = _index + 1;
+  if (i >= _count)
+  {
+    if (!_repeat)
+    {
+      _cyclesLeft = 1;    // stay put, check again next cycle
+      _finished = true;
+      return false;
+    }
+    i = 0;
+  }
+  _index = i;
+  _cyclesLeft = _frames[i].cycles;
+  _shown = _frames[i].digits;
+  return true;
+}
@@ -0,0 +1,65 @@
+#ifndef IO22_Sequencer_h
+
+#define IO22_Sequencer_h
+
+#include "Arduino.h"
+
+class IO22DisplaySequence
+{
+  // a display sequence: precomputed display frames, each shown for a number
+  // of refresh cycles, played by the board's refresh (see
+  // IO22D08Base::playSequence())
+  // - a frame is fully rendered digit words (shift register words, as in the
+  //   display buffers), so moving on to the next frame is a pointer bump in
+  //   the refresh path: no glyph lookups or rendering while it plays
+  // - frames are added by the board's sequence*() builders (scrolling text,
+  //   blinking digits/colon, or the display as it stands for alternating
+  //   frames); fixed capacity, no allocation
+  // - a refresh cycle is all four digits: 8ms with the background refresh at
+  //   its default 500Hz (see IO22D08Base::setDigitDwell())
+  // - while playing the sequence belongs to the refresh (the Timer2 ISR);
+  //   clear() or add to it only once stopped
+  // - SRAM footprint: 10 bytes per frame + 8
+
+  public:
+    static const uint8_t capacity = 16;
+    static const uint8_t numDigits = 4;
+
+    IO22DisplaySequence() {}
+
+    void clear() { _count = 0; }
+    uint8_t length() { return _count; }
+    bool isFull() { return _count >= capacity; }
+    // repeat: loop back to the first frame (default); otherwise stay on the
+    // last one, isFinished() then returns true
+    void setRepeat(bool repeat) { _repeat = repeat; }
+    bool isFinished() { return _finished; }
+
+    // add a rendered frame shown for cycles refresh cycles (at least 1); false
+    // if the sequence is full
+    bool add(const uint16_t *digits, uint16_t cycles);
+
+    // refresh hooks; not for use by sketches
+    // - _start(): rewind; false if there's nothing to play
+    // - _tick(): once per refresh cycle; true when the frame's changed
+    bool _start();
+    bool _tick();
+    const uint16_t *_current() { return _shown; }
+
+  protected:
+    struct Frame
+    {
+      uint16_t digits[numDigits];
+      uint16_t cycles;
+    };
+
+    Frame _frames[capacity];
+    uint8_t _count = 0;
+    uint8_t _index = 0;
+    uint16_t _cyclesLeft = 0;
+    const uint16_t *_shown = nullptr;
+    bool _repeat = true;
+    volatile bool _finished = false;
+};
+
+#endif
@@ -0,0 +1,143 @@
+/*
+  cooperative fixed-rate task scheduler for the IO22D08 library
+
+  - time is compared as differences ((int32_t)(now - due) >= 0), so the
+    micros() wrap (every ~71 minutes) is seamless for any period up to ~35
+    minutes
+  - run() reads micros() once to pick the task, and once more when it
+    returns to time it; the lateness is measured from the due time to the
+    start of the run
+  - after a run the next release is normally still ahead; when it isn't, the
+    whole periods since are skipped in one step (a division, only when
+    behind) rather than run back to back to catch up
+*/
+
+#include "Arduino.h"
+#include "IO22_TaskScheduler.h"
+
+uint8_t IO22TaskScheduler::add(TaskFn fn, uint32_t periodUs, uint16_t budgetUs,
+  const __FlashStringHelper *name)
+{
+  if (_count >= capacity || !fn) return noTask;
+  Task &task = _tasks[_count];
+  task.fn = fn;
+  task.period = periodUs ? periodUs : 1;
+  task.due = micros();
+  task.budget = budgetUs;
+  task.name = name;
+  task.enabled = true;
+  task.lateness.count = 0;
+  task.longestRun = task.overruns = task.missed = 0;
+  return _count++;
+}
+
+void IO22TaskScheduler::begin()
+{
+  uint32_t now = micros();
+  for (uint8_t t = 0; t < _count; t++) _tasks[t].due = now;
+  reset();
+}
+
+bool IO22TaskScheduler::run()
+{
+  uint32_t now = micros();
+  for (uint8_t t = 0; t < _count; t++)
+  {
+    Task &task = _tasks[t];
+    if (!task.enabled || (int32_t)(now - task.due) < 0) continue;
+    _current = t;
+    _run(task, now);
+    _current = noTask;
+    return true;
+  }
+  return false;
+}
+
+void IO22TaskScheduler::_run(Task &task, uint32_t now)
+{
+  uint32_t late = now - task.due;
+  task.due += task.period;
+  if (late >= task.period)
+  {
+    uint32_t skipped = late / task.period;
+    task.due += skipped * task.period;
+    task.missed = task.missed + skipped > 0xFFFF ? 0xFFFF : task.missed + skipped;
+  }
+  task.fn();
+  uint32_t duration = micros() - now;
+  IO22Profiler::accumulate(task.lateness, late);
+  if (duration > task.longestRun) task.longestRun = duration > 0xFFFF ? 0xFFFF : duration;
+  if (task.budget && duration > task.budget && task.overruns < 0xFFFF) task.overruns++;
+}
+
+void IO22TaskScheduler::setEnabled(uint8_t id, bool enabled)
+{
+  if (id >= _count) return;
+  Task &task = _tasks[id];
+  if (enabled && !task.enabled) task.due = micros();
+  task.enabled = enabled;
+}
+
+uint32_t IO22TaskScheduler::slack()
+{
+  uint8_t higher = _current < _count ? _current : _count;
+  uint32_t now = micros();
+  uint32_t least = noDeadline;
+  for (uint8_t t = 0; t < higher; t++)
+  {
+    const Task &task = _tasks[t];
+    if (!task.enabled) continue;
+    int32_t left = task.due - now;
+    if (left <= 0) return 0;
+    if ((uint32_t)left < least) least = left;
+  }
+  return least;
+}
+
+bool IO22TaskScheduler::read(uint8_t id, IO22Profiler::Stats &lateness)
+{
+  if (id >= _count) return false;
+  lateness = _tasks[id].lateness;
+  return lateness.count;
+}
+
+void IO22TaskScheduler::reset()
+{
+  for (uint8_t t = 0; t < _count; t++)
+  {
+    Task &task = _tasks[t];
+    task.lateness.count = 0;
+    task.longestRun = task.overruns = task.missed = 0;
+  }
+}
+
+void IO22TaskScheduler::report(Print &out, bool resetAfter)
+{
+  for (uint8_t t = 0; t < _count; t++)
+  {
+    const Task &task = _tasks[t];
+    const IO22Profiler::Stats &s = task.lateness;
+    if (!s.count) continue;
+    if (task.name) out.print(task.name);
+    else
+    {
+      out.print(F("task"));
+      out.print(t);
+    }
+    out.print(F(": n="));
+    out.print(s.count);
+    out.print(F(" late min="));
+    out.print(s.min);
+    out.print(F(" avg="));
+    out.print(s.sum / s.count);
+    out.print(F(" max="));
+    out.print(s.max);
+    out.print(F(" run max="));
+    out.print(task.longestRun);
+    out.print(F("us overruns="));
+    out.print(task.overruns);
+    out.print(F(" missed="));
+    out.println(task.missed);
+  }
+  if (resetAfter) reset();
+}
@@ -0,0 +1,92 @@
+#ifndef IO22_TaskScheduler_h
+
+#define IO22_TaskScheduler_h
+
+#include "Arduino.h"
+#include "IO22_Profiler.h"
+
+class IO22TaskScheduler
+{
+  // cooperative fixed-rate tasks for loop(): input scan, timers, frequency
+  // tick, display updates, logging, each with a declared period (and
+  // optionally a time budget)
+  // - tasks are added in priority order, highest first: run() runs the
+  //   highest priority task that's due, one per call, so a task waits for at
+  //   most one lower priority task (the one already running) however far
+  //   behind the lower priority work is
+  // - fixed rate: each release is a period on from the previous one's due
+  //   time, not from when the task last ran, so lateness doesn't accumulate
+  //   as drift; a task that's a whole period (or more) behind skips the
+  //   releases it missed, keeping its phase, and counts them
+  // - per task stats: the lateness (start - due time, i.e. the jitter) as
+  //   IO22Profiler::Stats, in us; the longest run, and the runs over budget
+  // - slack(): for work that can be split up (e.g. writing out a log), the
+  //   time left before a higher priority task is due
+  // - micros() based (4us resolution), i.e. Timer0 only; no ISRs of its own
+  // - task IDs are 0..capacity-1, in the order added
+  // - SRAM footprint: 35 bytes per task + 2
+
+  public:
+    static const uint8_t capacity = 8;
+    static const uint8_t noTask = 0xFF;
+    static const uint32_t noDeadline = 0xFFFFFFFF;   // no higher priority task
+
+    typedef void (*TaskFn)();
+
+    IO22TaskScheduler() {}
+
+    // add a task: periodUs between releases; budgetUs: the longest run
+    // expected (0: no budget); name: for report(), e.g. F("scan")
+    // - the tasks start out due straight away (see begin()); returns the task
+    //   ID, or noTask when full
+    uint8_t add(TaskFn fn, uint32_t periodUs, uint16_t budgetUs = 0,
+      const __FlashStringHelper *name = nullptr);
+    // (re)start every task's schedule from now, e.g. at the end of setup(),
+    // so setup()'s duration doesn't count as missed releases
+    void begin();
+
+    // call from loop(), as often as possible; true if a task ran
+    bool run();
+
+    // a disabled task isn't run; enabling it restarts its schedule from now
+    void setEnabled(uint8_t id, bool enabled);
+    bool isEnabled(uint8_t id) { return id < _count && _tasks[id].enabled; }
+    // the task running (from within a task), or noTask
+    uint8_t current() { return _current; }
+    // us until the next higher priority task (than the one running) is due;
+    // 0 if one already is, noDeadline if there are none
+    uint32_t slack();
+
+    // lateness stats (us); false if the task hasn't run yet
+    bool read(uint8_t id, IO22Profiler::Stats &lateness);
+    uint16_t longestRun(uint8_t id) { return id < _count ? _tasks[id].longestRun : 0; }
+    uint16_t overruns(uint8_t id) { return id < _count ? _tasks[id].overruns : 0; }
+    uint16_t missed(uint8_t id) { return id < _count ? _tasks[id].missed : 0; }
+    void reset();
+    // one line per task that has run: name (or number), runs, lateness
+    // min/avg/max, longest run (us), overruns, missed releases; blocking
+    void report(Print &out, bool resetAfter = true);
+
+  protected:
+    struct Task
+    {
+      TaskFn fn;
+      uint32_t period;
+      uint32_t due;                   // micros() of the next release
+      uint16_t budget;
+      const __FlashStringHelper *name;
+      bool enabled;
+      IO22Profiler::Stats lateness;
+      uint16_t longestRun;            // us, saturating
+      uint16_t overruns;              // runs over budget
+      uint16_t missed;                // releases skipped
+    };
+
+    Task _tasks[capacity];
+    uint8_t _count = 0;
+    uint8_t _current = noTask;
+
+    void _run(Task &task, uint32_t now);
+};
+
+#endif
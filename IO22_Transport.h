@@ -0,0 +1,306 @@
+#ifndef IO22_Transport_h
+
+#define IO22_Transport_h
+
+#include "Arduino.h"
+#include "IO22_Platform.h"
+
+// shift register transports
+// - each transport pushes frames out to the (74HC595) shift register chain:
+//   select() starts a frame, write() shifts a byte out MSBFIRST (see display.md
+//   re. the 595's bit order), latch() completes the frame and latches it to
+//   the 595 outputs
+// - all members are static so the board template (IO22Board) inlines the
+//   frame straight into its refresh paths; no virtual calls or pin lookups
+// - the stock IO22D08 board uses latch = A2, clock = A3, data = 13; there's no
+//   idea why the board designers didn't use the hardware serial pins (SPI) but
+//   there it is: only the bit-bang transports work on an unmodified board
+// - the IO22C04 uses latch = 8, clock = 9, data = 7, and has transports of
+//   its own
+//
+// available transports:
+// - IO22BitBangShift: digitalWrite()/shiftOut(); portable, ~300us per frame
+// - IO22FastShift: direct port register bit-bang (ATmega328P), ~10us per frame
+// - IO22SpiShift: hardware SPI (ATmega328P), needs a reworked board with the
+//   shift register clock on 13 (SCK) and data on 11 (MOSI), ~3us per frame
+// - IO22UsartShift: USART0 in master SPI mode (ATmega328P), needs a reworked
+//   board with the clock on 4 (XCK0) and data on 1 (TXD0), ~3us per frame
+// - IO22C04BitBangShift, IO22C04FastShift: as above, for the IO22C04
+//
+// and for benchmarking/checking the frames (see examples/IO22D08Benchmark):
+// - IO22NullShift: discards the frames
+// - IO22RecordingShift: wraps another transport, recording the bytes and
+//   counting the frames and data line transitions
+
+
+// portable transport via the Arduino API
+class IO22BitBangShift
+{
+  public:
+    static const uint8_t latchPin = A2;
+    static const uint8_t clockPin = A3;
+    // - data is shifted out to the first register
+    static const uint8_t dataPin = 13;
+
+    static void begin()
+    {
+      pinMode(latchPin, OUTPUT);
+      pinMode(clockPin, OUTPUT);
+      pinMode(dataPin, OUTPUT);
+    }
+    static void select() { digitalWrite(latchPin, LOW); }
+    // - shiftOut() only accepts a byte at a time
+    static void write(uint8_t b) { shiftOut(dataPin, clockPin, MSBFIRST, b); }
+    static void latch() { digitalWrite(latchPin, HIGH); }
+};
+
+// as IO22BitBangShift, for the IO22C04
+class IO22C04BitBangShift
+{
+  public:
+    static const uint8_t latchPin = 8;
+    static const uint8_t clockPin = 9;
+    static const uint8_t dataPin = 7;
+
+    static void begin()
+    {
+      pinMode(latchPin, OUTPUT);
+      pinMode(clockPin, OUTPUT);
+      pinMode(dataPin, OUTPUT);
+    }
+    static void select() { digitalWrite(latchPin, LOW); }
+    static void write(uint8_t b) { shiftOut(dataPin, clockPin, MSBFIRST, b); }
+    static void latch() { digitalWrite(latchPin, HIGH); }
+};
+
+
+#ifdef IO22D08_AVR_M328
+
+// the pin assignments are fixed by the board, so the latch, clock and data
+// pins resolve at compile time to port bits; each set/clear is then a single
+// sbi/cbi instruction (also atomic wrt. any ISR touching the rest of the port)
+// - an unrolled bit costs ~6 cycles; the 24-bit frame ~10us vs. ~300us for
+//   digitalWrite() + 3 x shiftOut()
+// - the 74HC595 needs ~20ns clock high/low time, the AVR's single cycle
+//   (62.5ns) sbi/cbi is well clear of that
+class IO22FastShift
+{
+  public:
+    // A2 = PC2, A3 = PC3, 13 = PB5
+    static const uint8_t latchPin = A2;
+    static const uint8_t clockPin = A3;
+    static const uint8_t dataPin = 13;
+
+    static void begin() { IO22BitBangShift::begin(); }
+    static inline __attribute__((always_inline)) void select() { PORTC &= ~_BV(PORTC2); }
+    static inline __attribute__((always_inline)) void write(uint8_t b)
+    {
+      _bit(b, 7);
+      _bit(b, 6);
+      _bit(b, 5);
+      _bit(b, 4);
+      _bit(b, 3);
+      _bit(b, 2);
+      _bit(b, 1);
+      _bit(b, 0);
+    }
+    static inline __attribute__((always_inline)) void latch() { PORTC |= _BV(PORTC2); }
+
+  protected:
+    static inline __attribute__((always_inline)) void _bit(uint8_t b, uint8_t n)
+    {
+      if (b & (1 << n)) PORTB |= _BV(PORTB5); else PORTB &= ~_BV(PORTB5);
+      PORTC |= _BV(PORTC3);
+      PORTC &= ~_BV(PORTC3);
+    }
+};
+
+// as IO22FastShift, for the IO22C04; the 16-bit frame ~7us
+class IO22C04FastShift
+{
+  public:
+    // 8 = PB0, 9 = PB1, 7 = PD7
+    static const uint8_t latchPin = 8;
+    static const uint8_t clockPin = 9;
+    static const uint8_t dataPin = 7;
+
+    static void begin() { IO22C04BitBangShift::begin(); }
+    static inline __attribute__((always_inline)) void select() { PORTB &= ~_BV(PORTB0); }
+    static inline __attribute__((always_inline)) void write(uint8_t b)
+    {
+      _bit(b, 7);
+      _bit(b, 6);
+      _bit(b, 5);
+      _bit(b, 4);
+      _bit(b, 3);
+      _bit(b, 2);
+      _bit(b, 1);
+      _bit(b, 0);
+    }
+    static inline __attribute__((always_inline)) void latch() { PORTB |= _BV(PORTB0); }
+
+  protected:
+    static inline __attribute__((always_inline)) void _bit(uint8_t b, uint8_t n)
+    {
+      if (b & (1 << n)) PORTD |= _BV(PORTD7); else PORTD &= ~_BV(PORTD7);
+      PORTB |= _BV(PORTB1);
+      PORTB &= ~_BV(PORTB1);
+    }
+};
+
+// hardware SPI master, mode 0, MSB first, fosc/2 (8MHz)
+// - requires the board to be reworked: SR clock to 13 (SCK), SR data to 11
+//   (MOSI); latch stays on A2
+// - 11 is IN8 on the stock board, and SPI master mode requires SS (10, K4)
+//   to be an output, so IN8 and K4 are lost
+class IO22SpiShift
+{
+  public:
+    static const uint8_t latchPin = A2;
+    static const uint8_t clockPin = 13;   // SCK
+    static const uint8_t dataPin = 11;    // MOSI
+
+    static void begin()
+    {
+      pinMode(latchPin, OUTPUT);
+      pinMode(clockPin, OUTPUT);
+      pinMode(dataPin, OUTPUT);
+      pinMode(10, OUTPUT);                // SS: must not float low in master mode
+      SPCR = _BV(SPE) | _BV(MSTR);
+      SPSR = _BV(SPI2X);
+    }
+    static inline __attribute__((always_inline)) void select() { PORTC &= ~_BV(PORTC2); }
+    static inline __attribute__((always_inline)) void write(uint8_t b)
+    {
+      SPDR = b;
+      while (!(SPSR & _BV(SPIF))) {}
+    }
+    static inline __attribute__((always_inline)) void latch() { PORTC |= _BV(PORTC2); }
+};
+
+// USART0 in master SPI mode (MSPIM), mode 0, MSB first, fosc/2 (8MHz)
+// - requires the board to be reworked: SR clock to 4 (XCK0), SR data to 1
+//   (TXD0); latch stays on A2
+// - 4 is IN3 on the stock board, and the hardware serial port (Serial) is no
+//   longer available
+// - unlike SPI the transmitter is double buffered, so write() only waits for
+//   buffer space and latch() waits for the last byte to finish shifting
+class IO22UsartShift
+{
+  public:
+    static const uint8_t latchPin = A2;
+    static const uint8_t clockPin = 4;    // XCK0
+    static const uint8_t dataPin = 1;     // TXD0
+
+    static void begin()
+    {
+      pinMode(latchPin, OUTPUT);
+      UBRR0 = 0;
+      pinMode(clockPin, OUTPUT);          // XCK0 as output selects master mode
+      UCSR0C = _BV(UMSEL01) | _BV(UMSEL00);
+      UCSR0B = _BV(TXEN0);
+      UBRR0 = 0;                          // fosc/2; set after enabling the transmitter
+    }
+    static inline __attribute__((always_inline)) void select()
+    {
+      UCSR0A = _BV(TXC0);                 // clear transmit complete
+      PORTC &= ~_BV(PORTC2);
+    }
+    static inline __attribute__((always_inline)) void write(uint8_t b)
+    {
+      while (!(UCSR0A & _BV(UDRE0))) {}
+      UDR0 = b;
+    }
+    static inline __attribute__((always_inline)) void latch()
+    {
+      while (!(UCSR0A & _BV(TXC0))) {}
+      PORTC |= _BV(PORTC2);
+    }
+};
+
+#endif
+
+// no-op transport: the frame building cost on its own
+class IO22NullShift
+{
+  public:
+    static void begin() {}
+    static void select() {}
+    static void write(uint8_t) {}
+    static void latch() {}
+};
+
+// records the bytes passed through to Transport (up to capacity bytes since
+// the last reset(), i.e. capacity/3 frames) and counts frames, bytes and data
+// line transitions
+// - the transitions are those of the serial data line, MSB first, including
+//   the one from the previous byte's last bit: the shift register chain's
+//   share of the switching (EMI, supply noise) per frame
+// - the statics are per Transport/capacity instantiation
+template <class Transport = IO22NullShift, uint8_t capacity = 12>
+class IO22RecordingShift
+{
+  public:
+    static void begin() { Transport::begin(); }
+    static void select() { Transport::select(); }
+    static void write(uint8_t b)
+    {
+      Transport::write(b);
+      if (_recorded < capacity) _bytes[_recorded++] = b;
+      _bytesWritten++;
+      // bit n of x = bit n ^ bit n+1, bit 8 being the previous bit
+      uint8_t x = b ^ ((b >> 1) | (_lastBit << 7));
+      while (x)
+      {
+        x &= x - 1;
+        _dataTransitions++;
+      }
+      _lastBit = b & 0x01;
+    }
+    static void latch()
+    {
+      Transport::latch();
+      _frames++;
+    }
+
+    static void reset()
+    {
+      _recorded = 0;
+      _frames = 0;
+      _bytesWritten = 0;
+      _dataTransitions = 0;
+    }
+    static uint8_t recorded() { return _recorded; }
+    static const uint8_t *bytes() { return _bytes; }
+    static uint32_t frames() { return _frames; }
+    static uint32_t bytesWritten() { return _bytesWritten; }
+    static uint32_t dataTransitions() { return _dataTransitions; }
+
+  protected:
+    static uint8_t _bytes[capacity];
+    static uint8_t _recorded;
+    static uint8_t _lastBit;
+    static uint32_t _frames;
+    static uint32_t _bytesWritten;
+    static uint32_t _dataTransitions;
+};
+
+template <class Transport, uint8_t capacity> uint8_t IO22RecordingShift<Transport, capacity>::_bytes[capacity];
+template <class Transport, uint8_t capacity> uint8_t IO22RecordingShift<Transport, capacity>::_recorded = 0;
+template <class Transport, uint8_t capacity> uint8_t IO22RecordingShift<Transport, capacity>::_lastBit = 0;
+template <class Transport, uint8_t capacity> uint32_t IO22RecordingShift<Transport, capacity>::_frames = 0;
+template <class Transport, uint8_t capacity> uint32_t IO22RecordingShift<Transport, capacity>::_bytesWritten = 0;
+template <class Transport, uint8_t capacity> uint32_t IO22RecordingShift<Transport, capacity>::_dataTransitions = 0;
+
+
+// the default transport: the fastest that works on an unmodified board
+#ifdef IO22D08_FAST_SHIFT
+typedef IO22FastShift IO22DefaultShift;
+typedef IO22C04FastShift IO22C04DefaultShift;
+#else
+typedef IO22BitBangShift IO22DefaultShift;
+typedef IO22C04BitBangShift IO22C04DefaultShift;
+#endif
+
+
+#endif
@@ -0,0 +1,148 @@
+#ifndef GoldenFrames_h
+
+#define GoldenFrames_h
+
+// the benchmark's golden frame check, shared with the host build
+// (extras/host): the frames the original IO22D08 class shifted out, and the
+// comparison of a board's frames with them
+
+#include "IO22_IO_Board.h"
+
+const uint8_t frameBytes = IO22D08Traits::chainBytes;
+const uint8_t displayBytes = frameBytes * IO22D08Base::numDisplayDigits;
+
+// frames as hex, "U4.U3.U5 " per frame
+inline void printFrames(Print &out, const uint8_t *frames, uint8_t bytes)
+{
+  for (uint8_t b = 0; b < bytes; b++)
+  {
+    if (frames[b] < 0x10) out.print('0');
+    out.print(frames[b], HEX);
+    out.print(b % frameBytes == frameBytes - 1 ? ' ' : '.');
+  }
+  out.println();
+}
+
+// the golden frames: refreshDisplayAndRelays() with the original IO22D08
+// class (the shiftOut() version) after setColon(colon), displayNumber(number)
+// or displayMessage(message), and relaySet(RELAYS_ALL, relays)
+// - 4 frames of U4, U3, U5 each
+struct GoldenCase
+{
+  uint16_t number;
+  uint8_t message;    // noMessage: displayNumber(number)
+  bool colon;
+  uint8_t relays;
+};
+const uint8_t noMessage = 0xFF;
+
+const GoldenCase goldenCases[] PROGMEM =
+{
+  {0, noMessage, false, 0x00},
+  {0, noMessage, true, 0xFF},
+  {7, noMessage, false, 0x01},
+  {7, noMessage, true, 0x02},
+  {42, noMessage, false, 0x80},
+  {42, noMessage, true, 0x7F},
+  {1234, noMessage, false, 0x5A},
+  {1234, noMessage, true, 0xA5},
+  {5678, noMessage, false, 0x0F},
+  {5678, noMessage, true, 0xF0},
+  {9012, noMessage, false, 0x11},
+  {9012, noMessage, true, 0x22},
+  {3456, noMessage, false, 0x44},
+  {3456, noMessage, true, 0x88},
+  {7890, noMessage, false, 0x3C},
+  {7890, noMessage, true, 0xC3},
+  {8888, noMessage, false, 0xFF},
+  {8888, noMessage, true, 0x00},
+  {9999, noMessage, false, 0x96},
+  {9999, noMessage, true, 0x69},
+  {0, IO22D08Base::MESSAGE_BLANK, false, 0x00},
+  {0, IO22D08Base::MESSAGE_ON, true, 0x01},
+  {0, IO22D08Base::MESSAGE_OFF, false, 0x80},
+  {0, IO22D08Base::MESSAGE_ERR, true, 0xFF},
+};
+const uint8_t numGoldenCases = sizeof(goldenCases) / sizeof(goldenCases[0]);
+
+const uint8_t goldenFrames[numGoldenCases][displayBytes] PROGMEM =
+{
+  {0x08, 0x24, 0x00,  0x0A, 0x20, 0x00,  0x0C, 0x20, 0x00,  0x28, 0x20, 0x00},
+  {0x08, 0x24, 0xFF,  0x0A, 0x00, 0xFF,  0x0C, 0x00, 0xFF,  0x28, 0x20, 0xFF},
+  {0x08, 0x24, 0x01,  0x0A, 0x20, 0x01,  0x0C, 0x20, 0x01,  0x28, 0x6A, 0x01},
+  {0x08, 0x24, 0x02,  0x0A, 0x00, 0x02,  0x0C, 0x00, 0x02,  0x28, 0x6A, 0x02},
+  {0x08, 0x24, 0x80,  0x0A, 0x20, 0x80,  0x04, 0x3A, 0x80,  0x20, 0xE0, 0x80},
+  {0x08, 0x24, 0x7F,  0x0A, 0x00, 0x7F,  0x04, 0x1A, 0x7F,  0x20, 0xE0, 0x7F},
+  {0x08, 0x7E, 0x5A,  0x02, 0xE0, 0x5A,  0x04, 0x62, 0x5A,  0x20, 0x3A, 0x5A},
+  {0x08, 0x7E, 0xA5,  0x02, 0xC0, 0xA5,  0x04, 0x42, 0xA5,  0x20, 0x3A, 0xA5},
+  {0x10, 0x26, 0x0F,  0x12, 0x20, 0x0F,  0x0C, 0x6A, 0x0F,  0x20, 0x20, 0x0F},
+  {0x10, 0x26, 0xF0,  0x12, 0x00, 0xF0,  0x0C, 0x4A, 0xF0,  0x20, 0x20, 0xF0},
+  {0x00, 0x26, 0x11,  0x0A, 0x20, 0x11,  0x0C, 0x7A, 0x11,  0x20, 0xE0, 0x11},
+  {0x00, 0x26, 0x22,  0x0A, 0x00, 0x22,  0x0C, 0x5A, 0x22,  0x20, 0xE0, 0x22},
+  {0x00, 0x66, 0x44,  0x02, 0x3A, 0x44,  0x14, 0x22, 0x44,  0x30, 0x20, 0x44},
+  {0x00, 0x66, 0x88,  0x02, 0x1A, 0x88,  0x14, 0x02, 0x88,  0x30, 0x20, 0x88},
+  {0x08, 0x6E, 0x3C,  0x02, 0x20, 0x3C,  0x04, 0x22, 0x3C,  0x28, 0x20, 0x3C},
+  {0x08, 0x6E, 0xC3,  0x02, 0x00, 0xC3,  0x04, 0x02, 0xC3,  0x28, 0x20, 0xC3},
+  {0x00, 0x24, 0xFF,  0x02, 0x20, 0xFF,  0x04, 0x20, 0xFF,  0x20, 0x20, 0xFF},
+  {0x00, 0x24, 0x00,  0x02, 0x00, 0x00,  0x04, 0x00, 0x00,  0x20, 0x20, 0x00},
+  {0x00, 0x26, 0x96,  0x02, 0x22, 0x96,  0x04, 0x22, 0x96,  0x20, 0x22, 0x96},
+  {0x00, 0x26, 0x69,  0x02, 0x02, 0x69,  0x04, 0x02, 0x69,  0x20, 0x22, 0x69},
+  {0x18, 0xFE, 0x00,  0x1A, 0xFA, 0x00,  0x1C, 0xFA, 0x00,  0x38, 0xFA, 0x00},
+  {0x18, 0xFE, 0x01,  0x1A, 0xDA, 0x01,  0x0C, 0x00, 0x01,  0x30, 0x78, 0x01},
+  {0x18, 0xFE, 0x80,  0x0A, 0x20, 0x80,  0x14, 0xA8, 0x80,  0x30, 0xA8, 0x80},
+  {0x18, 0xFE, 0xFF,  0x12, 0x80, 0xFF,  0x14, 0xD8, 0xFF,  0x30, 0xF8, 0xFF},
+};
+
+inline bool isDarkFrame(const uint8_t *frame)
+{
+  uint16_t d = frame[0] | frame[1] << 8;
+  return (d & IO22D08Traits::segmentMask) == IO22D08Traits::segmentMask;
+}
+
+// the refresh doesn't shift out a dark frame over a dark frame with the same
+// relays (it would latch nothing new), so a golden frame like that matches
+// the frame not being there; the rest have to match byte for byte
+inline bool matchesGolden(const uint8_t *actual, uint8_t actualBytes, const uint8_t *golden)
+{
+  uint8_t a = 0;
+  for (uint8_t g = 0; g < displayBytes; g += frameBytes)
+  {
+    if (a + frameBytes <= actualBytes && !memcmp(actual + a, golden + g, frameBytes))
+      a += frameBytes;
+    else if (!(g && isDarkFrame(golden + g) && isDarkFrame(golden + g - frameBytes)
+      && golden[g + frameBytes - 1] == golden[g - 1]))
+      return false;
+  }
+  return a == actualBytes;
+}
+
+// every golden case with the given board (and its transport's recorder); the
+// mismatches are printed to out
+template <class Recorder, class Board>
+uint16_t checkGolden(Board &board, Print &out)
+{
+  uint8_t golden[displayBytes];
+  uint16_t failures = 0;
+  for (uint8_t c = 0; c < numGoldenCases; c++)
+  {
+    GoldenCase gc;
+    memcpy_P(&gc, &goldenCases[c], sizeof(gc));
+    memcpy_P(golden, goldenFrames[c], displayBytes);
+    board.setColon(gc.colon);
+    if (gc.message == noMessage) board.displayNumber(gc.number);
+    else board.displayMessage(gc.message);
+    board.relaySet(IO22D08Base::RELAYS_ALL, gc.relays);
+    Recorder::reset();
+    board.refreshDisplayAndRelays();
+    if (matchesGolden(Recorder::bytes(), Recorder::recorded(), golden)) continue;
+    failures++;
+    out.print(F("golden mismatch in case "));
+    out.println(c);
+    printFrames(out, Recorder::bytes(), Recorder::recorded());
+    printFrames(out, golden, displayBytes);
+  }
+  board.relaySet(IO22D08Base::RELAYS_ALL, IO22D08Base::RELAY_OFF);
+  return failures;
+}
+
+#endif
@@ -0,0 +1,351 @@
+/* examples/IO22D08Benchmark/IO22D08Benchmark.ino
+
+  The IO22D08 is an I/O board for an Arduino Pro Mini; it provides:
+  - 8 x relay outputs (10A NO/NC outputs) + LED per channel
+  - 8 x optically isolated inputs
+  - 4 x pushbuttons
+  - 4 x 9-segment LED display (88:88), handy for time/state info
+
+  This example program is a benchmark and regression check for the library
+rather than an application; run it on the board (or in a simulator) after a
+change to the rendering or refresh paths and compare the output with that of
+the previous version.
+- regression checks: the frames shifted out for a set of values, colon states
+  and relay bytes are compared with golden frames captured from the original
+  (pre-template) IO22D08 class, with each of the transports (GoldenFrames.h;
+  extras/host runs the same check on a PC); and the frames for every
+  displayNumber() value (0-9999) are compared with those of the same digits
+  drawn one at a time with displayCharacter(), displayTime() with
+  displayNumber(), and the relay byte in each frame with relaySet(); the
+  frames are captured by a recording transport (IO22RecordingShift) so
+  nothing needs to be connected
+- benchmarks: cycles (IO22Clock, 62.5ns) per call of the rendering, refresh
+  and input paths with each of the transports that work on a stock board,
+  frames per second, the number of data line transitions per refresh and the
+  frames the refresh skips
+- the display and relays will flicker through various states while the
+  benchmark runs (the relay outputs are left disabled)
+- takes over Timer1 (IO22Clock)
+*/
+
+#include "IO22_IO_Board.h"
+#include "IO22_Clock.h"
+#include "GoldenFrames.h"
+
+// the cycle counter's (IO22Clock) Timer1 overflow vector
+IO22_CLOCK_ISRS()
+
+// frames captured without touching the pins (for the checks and the data line
+// counts); the stock board's transports as is (for the timing: the recording
+// would add to it)
+typedef IO22RecordingShift<> Recorder;
+IO22D08Board<Recorder> recordingBoard;
+IO22D08Board<IO22BitBangShift> bitBangBoard;
+#ifdef IO22D08_FAST_SHIFT
+IO22D08Board<IO22FastShift> fastBoard;
+#endif
+// the same transports, recorded, for the golden frames
+typedef IO22RecordingShift<IO22BitBangShift> BitBangRecorder;
+IO22D08Board<BitBangRecorder> bitBangRecordingBoard;
+#ifdef IO22D08_FAST_SHIFT
+typedef IO22RecordingShift<IO22FastShift> FastRecorder;
+IO22D08Board<FastRecorder> fastRecordingBoard;
+#endif
+
+// shift out the whole display and keep a copy of the frames
+void captureDisplay(uint8_t *frames)
+{
+  Recorder::reset();
+  recordingBoard.refreshDisplayAndRelays();
+  memcpy(frames, Recorder::bytes(), displayBytes);
+}
+
+bool compareDisplay(const __FlashStringHelper *name, uint16_t value, const uint8_t *actual, const uint8_t *expected)
+{
+  if (!memcmp(actual, expected, displayBytes)) return true;
+  Serial.print(name);
+  Serial.print(F(" mismatch at "));
+  Serial.println(value);
+  printFrames(Serial, actual, displayBytes);
+  printFrames(Serial, expected, displayBytes);
+  return false;
+}
+
+void printResult(const __FlashStringHelper *name, uint16_t failures)
+{
+  Serial.print(name);
+  Serial.print(F(": "));
+  if (failures)
+  {
+    Serial.print(failures);
+    Serial.println(F(" failures"));
+  }
+  else Serial.println(F("pass"));
+}
+
+// displayNumber() vs. per-digit displayCharacter() for all 4 digit values
+uint16_t checkDisplayNumber()
+{
+  uint8_t actual[displayBytes], expected[displayBytes];
+  uint16_t failures = 0;
+  for (uint16_t n = 0; n < 10000; n++)
+  {
+    recordingBoard.displayNumber(n);
+    captureDisplay(actual);
+    recordingBoard.beginDisplayUpdate();
+    recordingBoard.displayCharacter(0, n / 1000);
+    recordingBoard.displayCharacter(1, n / 100 % 10);
+    recordingBoard.displayCharacter(2, n / 10 % 10);
+    recordingBoard.displayCharacter(3, n % 10);
+    recordingBoard.endDisplayUpdate();
+    captureDisplay(expected);
+    if (!compareDisplay(F("displayNumber"), n, actual, expected) && ++failures >= 10) break;
+  }
+  return failures;
+}
+
+// displayTime(hi, lo) vs. displayNumber(hi*100 + lo)
+uint16_t checkDisplayTime()
+{
+  uint8_t actual[displayBytes], expected[displayBytes];
+  uint16_t failures = 0;
+  for (uint8_t hi = 0; hi < 100; hi++)
+  {
+    for (uint8_t lo = 0; lo < 100; lo++)
+    {
+      recordingBoard.displayTime(hi, lo);
+      captureDisplay(actual);
+      recordingBoard.displayNumber(hi * 100U + lo);
+      captureDisplay(expected);
+      if (!compareDisplay(F("displayTime"), hi * 100U + lo, actual, expected) && ++failures >= 10) return failures;
+    }
+  }
+  return failures;
+}
+
+// every frame carries the relay byte (the relay register is first in the
+// chain, and the latch is shared)
+uint16_t checkRelays()
+{
+  uint8_t frames[displayBytes];
+  uint16_t failures = 0;
+  recordingBoard.displayNumber(8888);
+  for (uint16_t r = 0; r < 256; r++)
+  {
+    recordingBoard.relaySet(IO22D08Base::RELAYS_ALL, r);
+    captureDisplay(frames);
+    for (uint8_t f = 0; f < IO22D08Base::numDisplayDigits; f++)
+      if (frames[f * frameBytes + frameBytes - 1] != r) failures++;
+  }
+  recordingBoard.relaySet(IO22D08Base::RELAYS_ALL, IO22D08Base::RELAY_OFF);
+  return failures;
+}
+
+
+void printCycles(const __FlashStringHelper *name, uint32_t cycles, uint16_t reps)
+{
+  uint32_t c = cycles / reps;
+  Serial.print(name);
+  Serial.print(F(": "));
+  Serial.print(c);
+  Serial.print(F(" cycles ("));
+  Serial.print((float)c / IO22Clock::cyclesPerMicrosecond, 1);
+  Serial.println(F("us)"));
+}
+
+void printRate(const __FlashStringHelper *name, uint32_t frames, uint32_t cycles)
+{
+  Serial.print(name);
+  Serial.print(F(": "));
+  Serial.print((float)frames * F_CPU / cycles, 0);
+  Serial.println(F(" frames/s"));
+}
+
+void benchmarkRendering()
+{
+  const uint16_t reps = 1000;
+  uint32_t t;
+
+  Serial.flush();  // keep the TX ISR out of the measurements
+  t = IO22Clock::now();
+  for (uint16_t i = 0; i < reps; i++) recordingBoard.displayNumber(i * 7);
+  printCycles(F("displayNumber"), IO22Clock::now() - t, reps);
+
+  Serial.flush();
+  t = IO22Clock::now();
+  for (uint16_t i = 0; i < reps; i++) recordingBoard.displayTime(i % 60, i % 100);
+  printCycles(F("displayTime"), IO22Clock::now() - t, reps);
+
+  Serial.flush();
+  t = IO22Clock::now();
+  for (uint16_t i = 0; i < reps; i++) recordingBoard.toggleColon();
+  printCycles(F("toggleColon"), IO22Clock::now() - t, reps);
+}
+
+void benchmarkInputs()
+{
+  const uint16_t reps = 1000;
+  uint32_t t;
+  volatile uint16_t sink;
+
+  Serial.flush();
+  t = IO22Clock::now();
+  for (uint16_t i = 0; i < reps; i++) sink = recordingBoard.readInputsAndButtons();
+  printCycles(F("readInputsAndButtons"), IO22Clock::now() - t, reps);
+
+  Serial.flush();
+  t = IO22Clock::now();
+  for (uint16_t i = 0; i < reps; i++) sink = recordingBoard.scanInputs();
+  printCycles(F("scanInputs"), IO22Clock::now() - t, reps);
+  (void)sink;
+}
+
+void benchmarkRefresh()
+{
+  uint32_t t;
+
+  recordingBoard.displayNumber(1234);
+  Serial.flush();
+  Recorder::reset();
+  t = IO22Clock::now();
+  for (uint16_t i = 0; i < 1000; i++) recordingBoard.refreshDisplayAndRelays();
+  t = IO22Clock::now() - t;
+  printCycles(F("refreshDisplayAndRelays (no transport)"), t, 1000);
+
+  bitBangBoard.displayNumber(1234);
+  Serial.flush();
+  t = IO22Clock::now();
+  for (uint16_t i = 0; i < 20; i++) bitBangBoard.refreshDisplayAndRelays();
+  t = IO22Clock::now() - t;
+  printCycles(F("refreshDisplayAndRelays (bit bang)"), t, 20);
+  printRate(F("  bit bang"), 20UL * IO22D08Base::numDisplayDigits, t);
+
+#ifdef IO22D08_FAST_SHIFT
+  fastBoard.displayNumber(1234);
+  Serial.flush();
+  t = IO22Clock::now();
+  for (uint16_t i = 0; i < 1000; i++) fastBoard.refreshDisplayAndRelays();
+  t = IO22Clock::now() - t;
+  printCycles(F("refreshDisplayAndRelays (fast)"), t, 1000);
+  printRate(F("  fast"), 1000UL * IO22D08Base::numDisplayDigits, t);
+
+  Serial.flush();
+  t = IO22Clock::now();
+  for (uint16_t i = 0; i < 1000; i++) fastBoard.refreshStep();
+  printCycles(F("refreshStep (fast)"), IO22Clock::now() - t, 1000);
+#endif
+}
+
+// data line transitions per (4 frame) refresh for a few typical displays
+void transitionsFor(const __FlashStringHelper *name)
+{
+  Recorder::reset();
+  recordingBoard.refreshDisplayAndRelays();
+  Serial.print(name);
+  Serial.print(F(": "));
+  Serial.print(Recorder::dataTransitions());
+  Serial.print(F(" transitions/"));
+  Serial.print(Recorder::bytesWritten() * 8);
+  Serial.println(F(" bits"));
+}
+
+void benchmarkTransitions()
+{
+  recordingBoard.setColon(false);
+  recordingBoard.displayNumber(8888);
+  transitionsFor(F("8888"));
+  recordingBoard.displayNumber(1111);
+  transitionsFor(F("1111"));
+  recordingBoard.displayTime(12, 34);
+  recordingBoard.setColon(true);
+  transitionsFor(F("12:34"));
+  recordingBoard.relaySet(IO22D08Base::RELAYS_ALL, IO22D08Base::RELAY_ON);
+  transitionsFor(F("12:34, relays on"));
+  recordingBoard.relaySet(IO22D08Base::RELAYS_ALL, IO22D08Base::RELAY_OFF);
+}
+
+// frames skipped by the refresh (a dark frame over a dark frame), and the
+// bits per second that saves at the background refresh rate
+// (autoRefreshHz / 4 cycles per second)
+void skipsFor(const __FlashStringHelper *name)
+{
+  const uint16_t cycles = 100;
+  uint32_t shifted, skipped;
+  recordingBoard.resetFrameCounts();
+  for (uint16_t i = 0; i < cycles; i++) recordingBoard.refreshDisplayAndRelays();
+  recordingBoard.frameCounts(shifted, skipped);
+  Serial.print(name);
+  Serial.print(F(": "));
+  Serial.print(shifted);
+  Serial.print(F(" shifted, "));
+  Serial.print(skipped);
+  Serial.print(F(" skipped, "));
+  Serial.print(skipped * frameBytes * 8 * (IO22D08Base::autoRefreshHz / IO22D08Base::numDisplayDigits) / cycles);
+  Serial.println(F(" bits/s saved"));
+}
+
+void benchmarkFrameSkips()
+{
+  // the relay byte itself can't be skipped (see display.md): 8 of every
+  // frame's bits
+  Serial.print(F("relay byte: "));
+  Serial.print(8UL * IO22D08Base::autoRefreshHz);
+  Serial.println(F(" bits/s"));
+  recordingBoard.setColon(false);
+  recordingBoard.displayNumber(8888);
+  skipsFor(F("8888"));
+  recordingBoard.displayMessage(IO22D08Base::MESSAGE_ON);
+  skipsFor(F("  On"));
+  recordingBoard.setBrightness(128);
+  skipsFor(F("  On, dimmed"));
+  recordingBoard.setBrightness(255);
+}
+
+void setup() {
+  Serial.begin(9600);
+  IO22Clock::begin();
+  // the boards share the pins; the relays stay disabled throughout
+  recordingBoard.begin();
+  bitBangBoard.begin();
+  bitBangRecordingBoard.begin();
+#ifdef IO22D08_FAST_SHIFT
+  fastBoard.begin();
+  fastRecordingBoard.begin();
+#endif
+
+  Serial.println(F("\nIO22D08 benchmark"));
+
+  Serial.println(F("regression checks:"));
+  printResult(F("golden (no transport)"), checkGolden<Recorder>(recordingBoard, Serial));
+  printResult(F("golden (bit bang)"), checkGolden<BitBangRecorder>(bitBangRecordingBoard, Serial));
+#ifdef IO22D08_FAST_SHIFT
+  printResult(F("golden (fast)"), checkGolden<FastRecorder>(fastRecordingBoard, Serial));
+#endif
+  printResult(F("displayNumber"), checkDisplayNumber());
+  printResult(F("displayTime"), checkDisplayTime());
+  printResult(F("relays"), checkRelays());
+
+  Serial.println(F("rendering:"));
+  benchmarkRendering();
+  Serial.println(F("inputs:"));
+  benchmarkInputs();
+  Serial.println(F("refresh:"));
+  benchmarkRefresh();
+  Serial.print(F("frame cost (bit bang): "));
+  Serial.print(bitBangBoard.measureFrameCost());
+  Serial.println(F("ns"));
+#ifdef IO22D08_FAST_SHIFT
+  Serial.print(F("frame cost (fast): "));
+  Serial.print(fastBoard.measureFrameCost());
+  Serial.println(F("ns"));
+#endif
+  Serial.println(F("data line:"));
+  benchmarkTransitions();
+  Serial.println(F("frame skips:"));
+  benchmarkFrameSkips();
+
+  Serial.println(F("done"));
+}
+
+void loop() {
+}
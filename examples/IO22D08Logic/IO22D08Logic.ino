@@ -0,0 +1,71 @@
+/* examples/IO22D08Logic/IO22D08Logic.ino
+
+  The IO22D08 is an I/O board for an Arduino Pro Mini; it provides:
+  - 8 x relay outputs (10A NO/NC outputs) + LED per channel
+  - 8 x optically isolated inputs
+  - 4 x pushbuttons
+  - 4 x 9-segment LED display (88:88), handy for time/state info
+
+  This example program runs the relays from a logic program (see
+IO22_Logic.h) rather than from button handlers: each relay is a truth table
+over a few signals, evaluated once per input scan. The program:
+- R1 follows IN1
+- IN2 toggles R2 each time it goes active
+- K1 latches R3 on, K2 turns it off again
+- IN3 starts timer 0 (R4 on for 10s); K3 starts timer 1 (R5 on for 5s)
+- R6 is on while IN4 is active and IN5 isn't
+- R7 is on while either IN6 or IN7 is active
+- R8 is left to the sketch: K4 toggles it directly
+- the display shows the program's evaluation time (us, the worst seen), which
+  stays the same whatever the program
+*/
+
+#include "IO22_IO_Board.h"
+#include "IO22_RelayTimers.h"
+#include "IO22_Logic.h"
+
+IO22D08 io22d08;  // create an instance of the relay board
+// the background refresh's Timer2 vectors
+IO22_AUTO_REFRESH_ISRS()
+IO22RelayTimers relayTimers(io22d08);
+IO22Logic logic(io22d08, &relayTimers);
+
+void setup()
+{
+  io22d08.begin();
+  io22d08.enableRelays();
+  io22d08.enableAutoRefresh();
+
+  relayTimers.setTimeout(0, io22d08.RELAY4, 10);
+  relayTimers.setTimeout(1, io22d08.RELAY5, 5);
+
+  logic.setRelay(1, logic.TABLE_A, logic.SIG_IN1);
+  logic.setRelay(2, logic.TABLE_A_XOR_B, logic.SIG_PRESSED_IN1 + 1, logic.SIG_RELAY1 + 1);
+  logic.setRelay(3, logic.TABLE_SET_RESET, logic.SIG_K1, logic.SIG_K1 + 1, logic.SIG_RELAY1 + 2);
+  logic.setTimer(0, logic.TABLE_A, logic.SIG_PRESSED_IN1 + 2);
+  logic.setTimer(1, logic.TABLE_A, logic.SIG_PRESSED_K1 + 2);
+  logic.setRelay(6, logic.TABLE_A_AND_NOT_B, logic.SIG_IN1 + 3, logic.SIG_IN1 + 4);
+  logic.setRelay(7, logic.TABLE_A_OR_B, logic.SIG_IN1 + 5, logic.SIG_IN1 + 6);
+}
+
+void loop()
+{
+  static unsigned long lastScan;
+  static unsigned long worst;
+  unsigned long now = millis();
+  if (now - lastScan >= 5)
+  {
+    lastScan = now;
+    io22d08.scanInputs();
+    unsigned long t = micros();
+    logic.evaluate();
+    t = micros() - t;
+    if (io22d08.buttonsPressed() & 0x08) io22d08.relaySetN(8, !io22d08.relayIsOn(8));
+    if (t > worst)
+    {
+      worst = t;
+      io22d08.displayNumber(worst);
+    }
+  }
+  relayTimers.tick();
+}
@@ -0,0 +1,94 @@
+/* examples/IO22D08LowPower/IO22D08LowPower.ino
+
+  The IO22D08 is an I/O board for an Arduino Pro Mini; it provides:
+  - 8 x relay outputs (10A NO/NC outputs) + LED per channel
+  - 8 x optically isolated inputs
+  - 4 x pushbuttons
+  - 4 x 9-segment LED display (88:88), handy for time/state info
+
+  This example program puts the board to sleep between input changes (see
+IO22_Power.h). Usage/features:
+- the external inputs IN1-IN8 toggle the corresponding relay on activation
+- the display shows "run" while awake; after 10s without any input or button
+  activity it's turned off and the board sleeps (power-down) with the relays
+  latched as they were
+- any change on IN1-IN8 or K1-K4 wakes it: the input that woke it is acted on
+  straight away (without waiting for the debouncer) and the latency from the
+  input change to the relay latch is reported over Serial
+- the relay state is kept in EEPROM (IO22RelayRetain) and restored at power-on
+  by an instant-on begin(), latched before anything else is set up; the time
+  taken is reported over Serial
+*/
+
+#include "IO22_IO_Board.h"
+#include "IO22_Power.h"
+#include "IO22_ConfigStore.h"
+
+IO22D08 io22d08;  // create an instance of the relay board
+// the background refresh's Timer2 vectors
+IO22_AUTO_REFRESH_ISRS()
+// the pin change vectors, for the wake-up
+IO22_PIN_CHANGE_ISRS()
+
+const unsigned long idleTimeout = 10000;  // ms without activity before sleeping
+const unsigned long scanInterval = 5;     // ms between input scans
+unsigned long lastActivity;
+
+// the last 64 bytes of the ATmega328P's EEPROM
+IO22RelayRetain relayRetain(E2END + 1 - 2 * IO22RelayRetain::defaultEntries);
+
+// inputs already acted on at wake-up: their debounced press is ignored
+uint8_t wokenBy = 0;
+
+void toggleRelays(uint8_t inputs)
+{
+  for (uint8_t n = 1; n <= io22d08.numInputs; n++)
+    if (inputs & _BV(n - 1)) io22d08.relaySetN(n, !io22d08.relayIsOn(n));
+}
+
+void setup()
+{
+  io22d08.begin(io22d08.STARTUP_INSTANT_ON, relayRetain.load());
+  Serial.begin(9600);
+  Serial.print(F("relays restored at "));
+  Serial.print(io22d08.startupMicros());
+  Serial.println(F("us"));
+  io22d08.enableAutoRefresh();
+  io22d08.displayText(F("run"));
+  lastActivity = millis();
+}
+
+void loop()
+{
+  static unsigned long lastScan;
+  unsigned long now = millis();
+  if (now - lastScan >= scanInterval)
+  {
+    lastScan = now;
+    if (io22d08.scanInputs()) lastActivity = now;
+    uint8_t pressed = io22d08.inputsPressed();
+    uint8_t seen = pressed & wokenBy;
+    wokenBy &= ~pressed;
+    toggleRelays(pressed & ~seen);
+    relayRetain.update(io22d08.relayGet(io22d08.RELAYS_ALL));
+  }
+
+  if (now - lastActivity >= idleTimeout)
+  {
+    Serial.println(F("sleeping"));
+    Serial.flush();
+    IO22Power::sleep(io22d08, IO22Power::SLEEP_POWER_DOWN);
+
+    // act on the raw input that woke the board, then latch the relays now
+    // rather than on the next refresh
+    wokenBy = io22d08.readInputs();
+    toggleRelays(wokenBy);
+    io22d08.updateRelays();
+    IO22Power::markAction();
+    relayRetain.update(io22d08.relayGet(io22d08.RELAYS_ALL));
+
+    Serial.print(F("woken, latency (us): "));
+    Serial.println(IO22Power::wakeLatency());
+    lastActivity = millis();
+  }
+}
@@ -0,0 +1,67 @@
+/* examples/IO22D08ModbusSlave/IO22D08ModbusSlave.ino
+
+  The IO22D08 is an I/O board for an Arduino Pro Mini; it provides:
+  - 8 x relay outputs (10A NO/NC outputs) + LED per channel
+  - 8 x optically isolated inputs
+  - 4 x pushbuttons
+  - 4 x 9-segment LED display (88:88), handy for time/state info
+
+  This example program makes the IO22D08 a Modbus RTU slave (see
+IO22_ModbusRTU.h for the register map), e.g. for polling by a PLC over RS485.
+Usage/features:
+- an RS485 module (MAX485 or similar) on the Pro Mini's TX/RX pins, with its
+  DE/RE pins tied together on A4
+- slave address 1, 19200 baud, 8E1
+- coils 0-7 = relays 1-8, discrete inputs 0-11 = IN1-IN8, K1-K4, holding
+  registers 0-3 = the display (number, BCD, colon, brightness) and 16-31 the
+  relay timers' timeouts and time remaining
+- the inputs are scanned every 5ms (the discrete inputs are the debounced
+  state); the relay timers are ticked from loop()
+- the display is refreshed in the background (Timer2 interrupt)
+- the hardware serial port belongs to Modbus: there's no Serial output
+*/
+
+#include "IO22_IO_Board.h"
+#include "IO22_RelayTimers.h"
+#include "IO22_ModbusRTU.h"
+
+IO22D08 io22d08;  // create an instance of the relay board
+// the background refresh's Timer2 vectors
+IO22_AUTO_REFRESH_ISRS()
+IO22RelayTimers relayTimers(io22d08);
+IO22ModbusRTU modbus(io22d08, &relayTimers);
+// the slave's USART/Timer1 vectors (this sketch's only: no Serial)
+IO22_MODBUS_RTU_ISRS()
+// the Timer1 overflow vector of the cycle counter (IO22Clock) the slave runs on
+IO22_CLOCK_ISRS()
+
+const uint8_t slaveAddress = 1;
+const uint32_t baud = 19200;
+const uint8_t driverEnablePin = A4;
+
+void setup()
+{
+  io22d08.begin();
+  io22d08.displayMessage(io22d08.MESSAGE_BLANK);
+  io22d08.enableRelays();
+  io22d08.enableAutoRefresh();
+
+  // a timer per relay, 10s each to start with (the master can change them)
+  for (uint8_t i = 0; i < io22d08.numRelays; i++)
+    relayTimers.setTimeout(i, io22d08.relayNumToMask(i + 1), 10);
+
+  modbus.begin(baud, slaveAddress, driverEnablePin, IO22ModbusRTU::PARITY_EVEN);
+}
+
+void loop()
+{
+  static unsigned long lastScan;
+  unsigned long now = millis();
+  if (now - lastScan >= 5)
+  {
+    lastScan = now;
+    io22d08.scanInputs();
+  }
+  relayTimers.tick();
+  modbus.poll();
+}
@@ -21,15 +21,38 @@ from the 4 onboard buttons and 8 external inputs. Usage/features:
   displaying c's, then finally a's
   - when no timers are running, the display is blanked except for the flashing
     colon (toggled every 0.5s)
-- the main loop runs at about 3.3ms (300Hz)
+- the display is refreshed in the background (Timer2 interrupt), loop() does
+  not need to call refreshDisplayAndRelays()
+- loop() is a task scheduler (see IO22_TaskScheduler.h): the inputs, timers,
+  display, colon and log run at fixed rates of their own, in that priority
+- loop() and library timing (see IO22_Profiler.h), and the tasks' timing, are
+  reported over Serial on demand: send 'p'
 */
 
+// profile the sketch and the board's refresh (define it in the build flags to
+// profile the rest of the library as well)
+#define IO22_PROFILE
+
 #include "IO22_IO_Board.h"
+#include "IO22_RelayTimers.h"
+#include "IO22_Log.h"
+#include "IO22_TaskScheduler.h"
 
 #include <AceButton.h>
 using namespace ace_button;
 
 IO22D08 io22d08;  // create an instance of the relay board
+// the background refresh's Timer2 vectors
+IO22_AUTO_REFRESH_ISRS()
+// the profiler's cycle counter (IO22Clock): the Timer1 overflow vector
+IO22_CLOCK_ISRS()
+
+// events are logged via a queue that's only written out while the Serial TX
+// buffer has room, so logging never holds up loop() (and the relays)
+IO22Log logger(Serial);
+
+// the sketch's work as fixed-rate tasks, highest priority first (see setup())
+IO22TaskScheduler scheduler;
 
 // AceButton is used to handle both the buttons K1-K4 and the inputs IN2-IN8
 // - relays (or timers) are switched via button handler callbacks
@@ -40,62 +63,23 @@ ButtonConfig inputConfig;
 AceButton inputs[io22d08.numInputs];
 
 
-// simple timer controlling one or more relays that turns them on with start()
-// and, when the elapsed time exceeds the given timeout, off via tick()
-// - relayMasks are used to allow multiple relays to be switched together
-class RelayTimer
+// relay timers: start() turns the timer's relays on, tick() turns them off
+// again once the timeout has elapsed
+const size_t numRelayTimers = io22d08.numRelays;  // for this demo, as many timers as relays
+IO22RelayTimers relayTimers(io22d08);
+
+void startTimer(uint8_t id)
 {
-  protected:
-    uint32_t _previousMillis = 0;
-    uint8_t _relayMask = 0;
-    uint16_t _timeout = 1000UL;
-    bool _isActive = false;
-
-  public:
-    RelayTimer() {}
-
-    void setTimeout(uint8_t rm, uint16_t t)
-    {
-      _relayMask = rm;
-      _timeout = t * 1000UL;
-    }
-
-    void start()
-    {
-      Serial.print(F("T("));
-      Serial.print(_relayMask);
-      Serial.println(F("):ON"));
-      _previousMillis = millis();
-      _isActive = true;
-      // if _relayMask is 0, will be a no-op
-      io22d08.relaySet(_relayMask, io22d08.RELAY_ON);
-    }
-
-    void stop()
-    {
-      Serial.print(F("T("));
-      Serial.print(_relayMask);
-      Serial.println(F("):OFF"));
-      _isActive = false;
-      io22d08.relaySet(_relayMask, io22d08.RELAY_OFF);
-    }
-
-    void tick()
-    {
-      if (_isActive)
-        if (millis() - _previousMillis > _timeout) stop();
-    }
-
-    uint16_t getTimeRemaining()
-    {
-      if (_isActive)
-        return _timeout - (millis() - _previousMillis);
-      return -1;  // maxtime
-    }
-};
+  relayTimers.start(id);
+  logger.record(F("T"), relayTimers.relayMask(id), F("ON"));
+}
 
-const size_t numRelayTimers = io22d08.numRelays;  // for this demo, as many timers as relays
-RelayTimer relayTimers[numRelayTimers];
+void tickTimers()
+{
+  uint8_t expired = relayTimers.tick();
+  if (expired) logger.record(F("T"), expired, F("OFF"));
+  io22d08.updateRelays();  // latch any relay changes right away
+}
 
 // handler for the onboard buttons K1-K4
 // - in this example a short-press starts the timer for relays 1-4 and a
@@ -106,10 +90,7 @@ void buttonHandler(AceButton* button, uint8_t eventType, uint8_t /*buttonState*/
 {
   uint8_t buttonId = button->getId();
 
-  Serial.print(F("B"));
-  Serial.print(buttonId);
-  Serial.print(F(":"));
-  Serial.println(AceButton::eventName(eventType));
+  logger.record(F("B"), buttonId, AceButton::eventName(eventType));
 
   switch (eventType) {
     case AceButton::kEventLongPressed:
@@ -117,7 +98,7 @@ void buttonHandler(AceButton* button, uint8_t eventType, uint8_t /*buttonState*/
       [[fallthrough]];
     case AceButton::kEventClicked:
       // buttonIDs are not necessarily aligned with timer indices
-      relayTimers[(buttonId-1)%numRelayTimers].start();  // button N => timer N-1
+      startTimer((buttonId-1)%numRelayTimers);  // button N => timer N-1
       break;
   }
 }
@@ -130,10 +111,7 @@ void buttonHandler(AceButton* button, uint8_t eventType, uint8_t /*buttonState*/
 void inputHandler(AceButton* button, uint8_t eventType, uint8_t /*buttonState*/)
 {
   uint8_t inputNum = button->getId();
-  Serial.print(F("I"));
-  Serial.print(inputNum);
-  Serial.print(F(":"));
-  Serial.println(AceButton::eventName(eventType));
+  logger.record(F("I"), inputNum, AceButton::eventName(eventType));
 
   switch (eventType) {
     case AceButton::kEventPressed:
@@ -147,7 +125,7 @@ void inputHandler(AceButton* button, uint8_t eventType, uint8_t /*buttonState*/)
       break;
     case AceButton::kEventDoubleClicked:
       // buttonIDs are not necessarily aligned with timer indices
-      relayTimers[(inputNum-1)%numRelayTimers].start();  // input N => timer N-1
+      startTimer((inputNum-1)%numRelayTimers);  // input N => timer N-1
       break;
   }
 }
@@ -157,6 +135,7 @@ void setup() {
   io22d08.begin();
   io22d08.displayMessage(io22d08.MESSAGE_BLANK);  // clear the display
   io22d08.enableRelays();
+  io22d08.enableAutoRefresh();
 
   Serial.println(F("\nIO22D08"));
 
@@ -196,65 +175,78 @@ void setup() {
   // update numRelayTimers to reflect the number of timers being used
   Serial.print(F("set relay timers: "));
   size_t i = 0;
-  relayTimers[i++].setTimeout(io22d08.RELAY1, 4);
-  relayTimers[i++].setTimeout(io22d08.RELAY2, 6);
-  relayTimers[i++].setTimeout(io22d08.RELAY3, 8);
-  relayTimers[i++].setTimeout(io22d08.RELAY4, 10);
-  relayTimers[i++].setTimeout(io22d08.RELAY5, 12);
-  relayTimers[i++].setTimeout(io22d08.RELAY6, 16);
-  relayTimers[i++].setTimeout(io22d08.RELAY7, 20);
-  relayTimers[i++].setTimeout(io22d08.RELAY8, 30);
+  relayTimers.setTimeout(i++, io22d08.RELAY1, 4);
+  relayTimers.setTimeout(i++, io22d08.RELAY2, 6);
+  relayTimers.setTimeout(i++, io22d08.RELAY3, 8);
+  relayTimers.setTimeout(i++, io22d08.RELAY4, 10);
+  relayTimers.setTimeout(i++, io22d08.RELAY5, 12);
+  relayTimers.setTimeout(i++, io22d08.RELAY6, 16);
+  relayTimers.setTimeout(i++, io22d08.RELAY7, 20);
+  relayTimers.setTimeout(i++, io22d08.RELAY8, 30);
   Serial.print(i);
   Serial.print("/");
   Serial.print(numRelayTimers);
   Serial.println(F("✔️"));
 
-  pinMode(A4, OUTPUT);  // loop() interval measurement
+  // rates: AceButton wants check() every few ms (it debounces on its own);
+  // the display and colon are human scale; the log only has to keep up with
+  // the UART
+  scheduler.add(checkInputs, 5000, 500, F("inputs"));
+  scheduler.add(tickTimers, 10000, 200, F("timers"));
+  scheduler.add(updateDisplay, 250000, 1000, F("display"));
+  scheduler.add(toggleColon, 500000, 100, F("colon"));
+  scheduler.add(writeLog, 20000, 2000, F("log"));
+
+  IO22_PROFILE_BEGIN();
+  scheduler.begin();
 }
 
-uint16_t _getMinTimeRemaining(uint16_t mtr, RelayTimer* timers, size_t nTimers)
+void checkInputs()
 {
-  for (size_t n = 0; n < nTimers; n++)
-  {
-    uint16_t tr = timers[n].getTimeRemaining();
-    if (tr < mtr) mtr = tr;
-  }
-  return mtr;
+  for (auto & b : buttons) b.check();
+  for (auto & i : inputs) i.check();
+  io22d08.updateRelays();
 }
 
-void loop()
+// display the (active) timer that is expiring next (i.e. lowest delta)
+// - clear + redraw as a single update so the refresh never shows the
+//   intermediate blank display
+void updateDisplay()
 {
-  static unsigned long previousMillis[] = {0, 0};
-  const uint8_t PREVIOUS_MILLIS_COLON = 0;    // colon update
-  const uint8_t PREVIOUS_MILLIS_DISPLAY = 1;  // display update
-  unsigned long currentMillis;
-  currentMillis = millis();
-
-  // colon flash is asynchronous to timer and display updates
-  if (currentMillis - previousMillis[PREVIOUS_MILLIS_COLON] > 500)
+  io22d08.beginDisplayUpdate();
+  io22d08.displayMessage(io22d08.MESSAGE_BLANK);  // clear the display
+  uint32_t mtr = relayTimers.nextTimeRemaining();
+  if (mtr != relayTimers.noDeadline)
   {
-    previousMillis[PREVIOUS_MILLIS_COLON] = currentMillis;
-    io22d08.toggleColon();
+    io22d08.displayNumber(mtr/1000UL + 1); // +1: crude ceil()
   }
+  io22d08.endDisplayUpdate();
+}
+
+// colon flash is asynchronous to timer and display updates
+void toggleColon()
+{
+  io22d08.toggleColon();
+}
 
-  // update display
-  if (currentMillis - previousMillis[PREVIOUS_MILLIS_DISPLAY] > 250)
+// - the report is blocking: it shows up as the log task's overrun, while the
+//   tasks above it only see the one late start
+void writeLog()
+{
+  logger.flush();
+  if (Serial.available() && Serial.read() == 'p')
   {
-    previousMillis[PREVIOUS_MILLIS_DISPLAY] = currentMillis;
-    // display the (active) timer that is expiring next (i.e. lowest delta)
-    io22d08.displayMessage(io22d08.MESSAGE_BLANK);  // clear the display
-    uint16_t mtr = UINT16_MAX;
-    mtr = _getMinTimeRemaining(mtr, relayTimers, numRelayTimers);
-    if (mtr != UINT16_MAX)
-    {
-      io22d08.displayNumber(mtr/1000UL + 1); // +1: crude ceil()
-    }
+    logger.flushAll();  // the report is written directly, keep it in order
+    IO22_PROFILE_REPORT(Serial);
+    scheduler.report(Serial);
   }
+}
 
-  for (auto & b : buttons) b.check();
-  for (auto & i : inputs) i.check();
-  for (auto & t : relayTimers) t.tick();
+void loop()
+{
+  scheduler.run();
 
-  io22d08.refreshDisplayAndRelays();
-  digitalWrite(A4, digitalRead(A4)==HIGH?LOW:HIGH); // to measure loop time
+  // no refreshDisplayAndRelays() needed: Timer2 keeps the display and relays
+  // refreshed
+  IO22_PROFILE_LOOP();
 }
@@ -16,19 +16,56 @@ frequency.
 - the buttons K1-K4, other inputs IN2-IN8, and display are the same as for
   IO22D08Timers
 
-  In addition, a "test mode" is provided that runs an alternate loop() if the
-K1 button is held down in setup() when powering on. The test mode cycles various
-values through the display and toggles the relay enable control.
-
+  In addition, a "test mode" is provided that runs an alternate set of tasks
+if the K1 button is held down in setup() when powering on. The test mode starts with
+the board's power-on self-test (each segment and digit select lit in turn, see
+IO22Board::selfTest()), then cycles various values through the display and
+toggles the relay enable control. The startup time (to the relays being
+ready) is reported over Serial.
+
+  loop() is a task scheduler (see IO22_TaskScheduler.h): the display refresh,
+inputs, timers, frequency switch, display updates and log each run at a fixed
+rate of their own, highest priority first. The display is refreshed
+incrementally with refreshStep(), one digit per 1ms task run, keeping each
+run's cost down to a single frame.
+
+- the relay timers and the frequency thresholds are settings, kept in EEPROM
+  (see IO22_ConfigStore.h) and loaded at boot; the defaults below are used
+  (and saved) on first boot. Change them over Serial, one command per line:
+  - "t <timer> <seconds>", e.g. "t 2 25": timer 2 (of 0-7) runs for 25s
+  - "f <stopped> <lower> <upper>": the frequency thresholds, periods in us
+  - the change is applied and saved straight away
+- loop() and library timing (see IO22_Profiler.h), and the tasks' timing, are
+  reported over Serial on demand: send 'p'
 */
 
+// profile the sketch and the board's refresh (define it in the build flags to
+// profile the rest of the library as well)
+#define IO22_PROFILE
+
 #include "IO22_IO_Board.h"
+#include "IO22_RelayTimers.h"
+#include "IO22_Log.h"
+#include "IO22_FrequencyInput.h"
+#include "IO22_EventQueue.h"
+#include "IO22_ConfigStore.h"
+#include "IO22_TaskScheduler.h"
 
 #include <AceButton.h>
 using namespace ace_button;
 
 IO22D08 io22d08;  // create an instance of the relay board
 
+// events are logged via a queue that's only written out while the Serial TX
+// buffer has room, so logging never holds up loop() (and the relays)
+IO22Log logger(Serial);
+
+// the sketch's work as fixed-rate tasks, highest priority first (see setup());
+// the test mode swaps the display tasks for its own
+IO22TaskScheduler scheduler;
+uint8_t mainTasks[3];
+uint8_t testTask;
+
 // AceButton is used to handle both the buttons K1-K4 and the inputs IN2-IN8
 // - relays (or timers) are switched via button handler callbacks
 ButtonConfig buttonConfig;
@@ -38,62 +75,40 @@ ButtonConfig inputConfig;
 AceButton inputs[io22d08.numInputs];
 
 
-// simple timer controlling one or more relays that turns them on with start()
-// and, when the elapsed time exceeds the given timeout, off via tick()
-// - relayMasks are used to allow multiple relays to be switched together
-class RelayTimer
-{
-  protected:
-    uint32_t _previousMillis = 0;
-    uint8_t _relayMask = 0;
-    uint16_t _timeout = 1000UL;
-    bool _isActive = false;
-
-  public:
-    RelayTimer() {}
-
-    void setTimeout(uint8_t rm, uint16_t t)
-    {
-      _relayMask = rm;
-      _timeout = t * 1000UL;
-    }
-
-    void start()
-    {
-      Serial.print(F("T("));
-      Serial.print(_relayMask);
-      Serial.println(F("):ON"));
-      _previousMillis = millis();
-      _isActive = true;
-      // if _relayMask is 0, will be a no-op
-      io22d08.relaySet(_relayMask, io22d08.RELAY_ON);
-    }
+// relay timers: start() turns the timer's relays on, tick() turns them off
+// again once the timeout has elapsed
+const size_t numRelayTimers = io22d08.numRelays;  // for this demo, as many timers as relays
+IO22RelayTimers relayTimers(io22d08);
 
-    void stop()
-    {
-      Serial.print(F("T("));
-      Serial.print(_relayMask);
-      Serial.println(F("):OFF"));
-      _isActive = false;
-      io22d08.relaySet(_relayMask, io22d08.RELAY_OFF);
-    }
+// settings: loaded from EEPROM by setup(), saved on change
+IO22ConfigStore configStore;
+IO22Config config;
 
-    void tick()
-    {
-      if (_isActive)
-        if (millis() - _previousMillis > _timeout) stop();
-    }
+void defaultConfig()
+{
+  const uint8_t relays[] = {io22d08.RELAY1, io22d08.RELAY2, io22d08.RELAY3, io22d08.RELAY4,
+    io22d08.RELAY5, io22d08.RELAY6, io22d08.RELAY7, io22d08.RELAY8};
+  const uint16_t seconds[] = {4, 6, 8, 10, 12, 16, 20, 30};
+  for (size_t i = 0; i < numRelayTimers; i++) config.timers[i] = {relays[i], seconds[i]};
+  // thresholds are periods in us, so inverted:
+  // - 2Hz = 500ms, 20Hz = 50ms, 15Hz = 66ms
+  config.frequencyThresholds[0] = 500e3;
+  config.frequencyThresholds[1] = 50e3;
+  config.frequencyThresholds[2] = 66e3;
+  config.brightness = 255;
+}
 
-    uint16_t getTimeRemaining()
-    {
-      if (_isActive)
-        return _timeout - (millis() - _previousMillis);
-      return -1;  // maxtime
-    }
-};
+void startTimer(uint8_t id)
+{
+  relayTimers.start(id);
+  logger.record(F("T"), relayTimers.relayMask(id), F("ON"));
+}
 
-const size_t numRelayTimers = io22d08.numRelays;  // for this demo, as many timers as relays
-RelayTimer relayTimers[numRelayTimers];
+void tickTimers()
+{
+  uint8_t expired = relayTimers.tick();
+  if (expired) logger.record(F("T"), expired, F("OFF"));
+}
 
 // handler for the onboard buttons K1-K4
 // - in this example a short-press starts the timer for relays 1-4 and a
@@ -104,10 +119,7 @@ void buttonHandler(AceButton* button, uint8_t eventType, uint8_t /*buttonState*/
 {
   uint8_t buttonId = button->getId();
 
-  Serial.print(F("B"));
-  Serial.print(buttonId);
-  Serial.print(F(":"));
-  Serial.println(AceButton::eventName(eventType));
+  logger.record(F("B"), buttonId, AceButton::eventName(eventType));
 
   switch (eventType) {
     case AceButton::kEventLongPressed:
@@ -115,7 +127,7 @@ void buttonHandler(AceButton* button, uint8_t eventType, uint8_t /*buttonState*/
       [[fallthrough]];
     case AceButton::kEventClicked:
       // buttonIDs are not necessarily aligned with timer indices
-      relayTimers[(buttonId-1)%numRelayTimers].start();  // button N => timer N-1
+      startTimer((buttonId-1)%numRelayTimers);  // button N => timer N-1
       break;
   }
 }
@@ -128,10 +140,7 @@ void buttonHandler(AceButton* button, uint8_t eventType, uint8_t /*buttonState*/
 void inputHandler(AceButton* button, uint8_t eventType, uint8_t /*buttonState*/)
 {
   uint8_t inputNum = button->getId();
-  Serial.print(F("I"));
-  Serial.print(inputNum);
-  Serial.print(F(":"));
-  Serial.println(AceButton::eventName(eventType));
+  logger.record(F("I"), inputNum, AceButton::eventName(eventType));
 
   switch (eventType) {
     case AceButton::kEventPressed:
@@ -145,167 +154,77 @@ void inputHandler(AceButton* button, uint8_t eventType, uint8_t /*buttonState*/)
       break;
     case AceButton::kEventDoubleClicked:
       // buttonIDs are not necessarily aligned with timer indices
-      relayTimers[(inputNum-1)%numRelayTimers].start();  // input N => timer N-1
+      startTimer((inputNum-1)%numRelayTimers);  // input N => timer N-1
       break;
   }
 }
 
 
-// frequency controlled switch for IN1 and/or IN2
+// frequency controlled switch for IN1
 //  - IN1,2 inputs are connected to the two external interrupt pins on the Mini
-//    and thus can readily monitor a frequency input
-//    - the other inputs could as well, via a pin change interrupt, but that's
-//      a lot more work (and will be slower)
-//
-// - can measure frequency either by
-//    1) counting the number of pulses in a given period
-//      - requires longer sample periods as the frequency decreases (or
-//        conversely loses resolution)
-//    2) measuring the period (e.g. time between rising edges)
-//      - loses resolution as the frequency increases
-//      - lower noise-immunity / greater impact from spurious pulses
+//    and thus can readily monitor a frequency input; IO22FrequencyInput
+//    timestamps each edge against a 62.5ns cycle counter and filters the
+//    period (see IO22_FrequencyInput.cpp)
 //
 // - for this example the expected input frequency range of ~1-120Hz
 //   (period: 100-8ms), with a desired 500ms update rate
-//   - either frequency measurement approach is viable / should work
-//   - at the lower frequency end the resolution of the pulse-counting approach
-//     will be relatively poor (i.e. only ~5 pulses per 500ms, so a 20% margin
-//     of error) so go with the period measuring approach
-//   - with a 500ms update rate there's budget to apply a filter to reduce noise
-//     on the frequency measurement; a simple moving average filter works well
-//    - https://en.wikipedia.org/wiki/Exponential_smoothing
-//    - expressed as the following, where u is the new sample, and x is the
-//      smoothed average:
-//      x = (1-alpha).x + (alpha).u
-//    - with alpha = 1/(2^n), this expression can be implemented via efficient
-//      add/subtract and bit shifts (i.e. 1/2^n = >>n)
-//      - e.g. https://electronics.stackexchange.com/a/34426/264328
-//      - https://forum.arduino.cc/t/implementing-exponential-moving-average-filter/428637/11
-//    - at very low frequencies and modest update rates sampling starts
-//      becoming a problem (i.e. when the incoming pulse train is at 2Hz, you
-//      can't get an update faster than 2Hz); one approach would be to use a
-//      multiplier PLL to construct a finer-grained representation of the input
-//
-// - with the interrupt-based approach to measuring the input signal, if the
-//   input signal is disconnected then the ISR won't be called and the frequency
-//   measurement will stop being updated, it'll stay 'stuck' at the last reading
-//    - if this is a problem for the application, it's easy to deal with via a
-//      periodic check outside of the ISR: if the last update was longer than
-//      some expected period, then zero it; this logic should also be reflected
-//      in the ISR averaging code as well - see PERIOD_MAX below
-//    - note as the input signal slows right down to DC, the above logic starts
-//      interfering with the real measurements (i.e. Q: when does "low
-//      frequency" become "stopped"? A: beyond PERIOD_MAX)
-// - some hysteresis is required to prevent chatter
-
-class FreqSwitch
+//   - at the lower frequency end the resolution of a pulse-counting approach
+//     would be relatively poor (i.e. only ~5 pulses per 500ms, so a 20% margin
+//     of error) hence the period measuring approach
+//   - at very low frequencies and modest update rates sampling starts
+//     becoming a problem (i.e. when the incoming pulse train is at 2Hz, you
+//     can't get an update faster than 2Hz); one approach would be to use a
+//     multiplier PLL to construct a finer-grained representation of the input
+//   - note as the input signal slows right down to DC "low frequency" and
+//     "stopped" start to blur (Q: when does "low frequency" become "stopped"?
+//     A: beyond the stopped threshold, PERIOD_MAX by default)
+IO22FrequencyInput freqSwitch;
+// the input's INT0/INT1 vectors, and the Timer1 overflow vector of the cycle
+// counter (IO22Clock) that timestamps its edges (and times the profiler)
+IO22_FREQUENCY_INPUT_ISRS()
+IO22_CLOCK_ISRS()
+
+
+// relay and frequency state changes are queued where they happen and
+// logged from loop(), a few at a time
+IO22EventQueue events;
+
+void reportEvents()
 {
-  public:
-    enum FSState {FS_STOPPED, FS_LOW, FS_HIGH}; // Arduino LOW/HIGH be stompin'
-
-  private:
-    // all values in this class are periods (intervals), in us, not frequencies
-
-    volatile unsigned long _previousMicros;
-
-    volatile unsigned long _period;   // last interval
-    volatile unsigned long _stopped;  // longer than this == stopped
-    volatile unsigned long _lower, _upper; // lower, upper hysteresis thresholds
-
-    const size_t _filterN = 2; // filter alpha = 1/1^n
-
-    FSState _state = FS_STOPPED; // initial state
-
-  public:
-    // anything longer than this is considered DC (stopped); making this too
-    // long will slow the filter response once the signal starts up again
-    const unsigned long PERIOD_MAX = 500*1000UL; // 500ms = 2Hz
-
-    FreqSwitch() {}
-
-    void setThresholds(unsigned long stopped, unsigned long lower, unsigned long upper)
-    {
-      _stopped = stopped;
-      _lower = lower;
-      _upper = upper;
-    }
-
-    unsigned long getPeriod() { return _period; }
-    FSState getState() { return _state; }
-
-    void sample() // this is called by the ISR; keep it short
+  IO22Event batch[4];
+  uint8_t n = events.drain(batch, 4);
+  for (uint8_t e = 0; e < n; e++)
+  {
+    switch (batch[e].type)
     {
-      // as the signal approaches DC this function will be called at increasing
-      // intervals; if the signal is removed it won't get called at all; and thus
-      // the period won't get updated
-      static unsigned long currentMicros;
-      static unsigned long periodN;  // period left-shifted (for averaging)
-      currentMicros = micros();
-      // have to do the filtering here to ensure we catch 'em all
-      // - see above re. this moving average calculation
-      periodN += (currentMicros - _previousMicros) - _period;
-      _period = periodN >> _filterN;
-      _previousMicros = currentMicros;
+      case IO22EventQueue::EVENT_RELAY:
+        logger.record(F("R"), batch[e].id, batch[e].value ? F("ON") : F("OFF"));
+        break;
+      case IO22EventQueue::EVENT_FREQUENCY:
+        logger.record(F("F"), batch[e].id, batch[e].value == freqSwitch.FS_HIGH ? F("HIGH") :
+          batch[e].value == freqSwitch.FS_LOW ? F("LOW") : F("STOPPED"));
+        break;
     }
-
-    int tick()
-    {
-      // high period == low speed and vice-versa; a high enough period == stopped
-
-      // LOW-HIGH hysteresis:
-      // transition state => FS_HIGH when period is now lower than lower threshold
-      // transition state => FS_LOW when period is now higher than upper threshold
-      // no change in between
-      switch (_state)
-      {
-        case FS_STOPPED:
-          if (_period < _stopped) _state = _period > _upper ? FS_LOW : FS_HIGH;
-          break;
-        case FS_LOW:
-          if (_period < _lower) _state = FS_HIGH;
-          if (_period > _stopped) _state = FS_STOPPED;
-          break;
-        case FS_HIGH:
-          if (_period > _upper) _state = FS_LOW;
-          if (_period > _stopped) _state = FS_STOPPED;
-          break;
-      }
-
-      // if the ISR hasn't been called "recently" (longer than the _stopped period),
-      // force to stopped state
-      // - this overrides the above FSM
-      if (micros() - _previousMicros > _stopped)
-      {
-        _state = FS_STOPPED;
-        // it might be tempting to force _period to the max here to "help" the
-        // sample() filter, but that will be problematic as this function and the
-        // ISR are totally asynchronous, manipulating any of the filter components
-        // here will give rise to aliasing effects
-      }
-
-      return _state;
   }
-};
-
-//  - it's easiest to use separate ISRs for each external interrupt
-//    - an ISR has limitations on its context (e.g. if part of the class, has to
-//      be a static member function: one and only one); if there is only one ISR
-//      shared between multiple instances you then have to determine which pin
-//      triggered the interrupt; you can try and mess around with reading and
-//      keeping track of the states of each pin to figure that out, but there
-//      are complexities including race conditions with that approach
-FreqSwitch freqSwitch;
-void _isr_freq() { freqSwitch.sample(); }
-
-void (*loop_fn)() = loop_main;  // allow switching between main and testmode
+  uint8_t dropped = events.takeDropped();
+  if (dropped) logger.record(F("events dropped="), dropped);
+}
 
 void setup() {
   Serial.begin(9600);
   io22d08.begin();
+  // settings first: one block read, before anything depends on them
+  bool configLoaded = configStore.load(config);
+  if (!configLoaded) defaultConfig();
+  io22d08.setBrightness(config.brightness);
   io22d08.displayMessage(io22d08.MESSAGE_BLANK);  // clear the display
   io22d08.enableRelays();
+  io22d08.setEventQueue(&events);
 
   Serial.println(F("\nIO22D08"));
+  Serial.print(F("startup: "));
+  Serial.print(io22d08.startupMicros());
+  Serial.println(F("us"));
 
   Serial.print(F("init buttons: K1-K4 "));
   buttonConfig.setEventHandler(buttonHandler);
@@ -320,12 +239,11 @@ void setup() {
   }
   Serial.println(F("✔️"));
 
-  Serial.print(F("init frequency input: IN1 (RELAY1) 15,20Hz "));
-  pinMode(io22d08.inputPins[0], INPUT);
-  attachInterrupt(digitalPinToInterrupt(io22d08.inputPins[0]), _isr_freq, RISING);
-  // thresholds are periods in ms, so inverted:
-  // - 2Hz = 500ms, 20Hz = 50ms, 15Hz = 66ms
-  freqSwitch.setThresholds(500e3, 50e3, 66e3);
+  Serial.print(F("init frequency input: IN1 (RELAY1) "));
+  freqSwitch.begin(1, RISING);
+  freqSwitch.setThresholds(config.frequencyThresholds[0], config.frequencyThresholds[1],
+    config.frequencyThresholds[2]);
+  freqSwitch.setEventQueue(&events);
   Serial.println(F("✔️"));
 
   Serial.print(F("init digital inputs: IN2-IN8 "));
@@ -347,43 +265,62 @@ void setup() {
   }
   Serial.println(F("✔️"));
 
+  // rates: the refresh needs 4 x 60Hz for a solid display (this gives it 4 x
+  // 250Hz); AceButton wants check() every few ms (it debounces on its own);
+  // the rest is human scale, and the log only has to keep up with the UART
+  scheduler.add(refreshDisplay, 1000, 100, F("refresh"));
+  scheduler.add(checkInputs, 5000, 500, F("inputs"));
+  scheduler.add(tickTimers, 10000, 200, F("timers"));
+  mainTasks[0] = scheduler.add(frequencySwitch, 500000, 1000, F("frequency"));
+  mainTasks[1] = scheduler.add(updateDisplay, 250000, 1000, F("display"));
+  mainTasks[2] = scheduler.add(toggleColon, 500000, 100, F("colon"));
+  testTask = scheduler.add(testmode, 1000000, 1000, F("testmode"));
+  scheduler.add(writeLog, 10000, 2000, F("log"));
+  scheduler.setEnabled(testTask, false);
+
   // go into test mode if K1 is held during boot
   if (buttons[0].isPressedRaw())
   {
     Serial.println(F("entering testmode"));
+    io22d08.selfTest();
     // some test timers
     // - relays 1-4 on for 4s; 5-8 on for 8s
-    // - note the testmode loop will cycle the relay enables as well
+    // - note the testmode task will cycle the relay enables as well
     uint8_t relayMask;
     relayMask = io22d08.RELAY1+io22d08.RELAY2+io22d08.RELAY3+io22d08.RELAY4;
-    relayTimers[0].setTimeout(relayMask, 4);
+    relayTimers.setTimeout(0, relayMask, 4);
     relayMask = io22d08.RELAY5+io22d08.RELAY6+io22d08.RELAY7+io22d08.RELAY8;
-    relayTimers[1].setTimeout(relayMask, 8);
+    relayTimers.setTimeout(1, relayMask, 8);
     // start the timers, once (then handover to "manual" control via buttons)
-    for (auto & t : relayTimers) t.start();
+    for (size_t t = 0; t < numRelayTimers; t++) startTimer(t);
 
-    loop_fn = loop_testmode;
+    for (uint8_t t : mainTasks) scheduler.setEnabled(t, false);
+    scheduler.setEnabled(testTask, true);
+    scheduler.begin();
     return;
   }
 
-  // set some demo timer values
-  // update numRelayTimers to reflect the number of timers being used
   Serial.print(F("set relay timers: "));
-  size_t i = 0;
-  relayTimers[i++].setTimeout(io22d08.RELAY1, 4);
-  relayTimers[i++].setTimeout(io22d08.RELAY2, 6);
-  relayTimers[i++].setTimeout(io22d08.RELAY3, 8);
-  relayTimers[i++].setTimeout(io22d08.RELAY4, 10);
-  relayTimers[i++].setTimeout(io22d08.RELAY5, 12);
-  relayTimers[i++].setTimeout(io22d08.RELAY6, 16);
-  relayTimers[i++].setTimeout(io22d08.RELAY7, 20);
-  relayTimers[i++].setTimeout(io22d08.RELAY8, 30);
-  Serial.print(i);
-  Serial.print("/");
+  config.applyTimers(relayTimers);
   Serial.print(numRelayTimers);
+  if (configLoaded)
+  {
+    Serial.print(F(" from config #"));
+    Serial.print(configStore.sequence());
+  }
+  else
+  {
+    configStore.save(config);
+    Serial.print(F(" defaults, saved"));
+  }
   Serial.println(F("✔️"));
 
-  pinMode(A4, OUTPUT);  // loop() interval measurement
+  Serial.print(F("display frame: "));
+  Serial.print(io22d08.measureFrameCost());
+  Serial.println(F("ns"));
+
+  IO22_PROFILE_BEGIN();
+  scheduler.begin();
 }
 
 
@@ -395,144 +332,181 @@ void setup() {
 const uint16_t testmodeNumbers[] = {0, 1234, 8, 80, 800, 8000, 8888};
 const size_t numTestmodeNumbers (sizeof(testmodeNumbers)/sizeof(testmodeNumbers[0]));
 
-void loop_testmode()
+void testmode()
 {
-  static unsigned long previousMillis = 0;
-  unsigned long currentMillis;
-  currentMillis = millis();
+  static uint8_t i = 0;
+  io22d08.displayNumber(testmodeNumbers[i]);
+  io22d08.setColon(i%2 ? false: true);
 
-  if (currentMillis - previousMillis > 1000)
+  // disable the relays for the 0'th display period
+  if (i)
   {
-    previousMillis = currentMillis;
-    uint8_t i = (currentMillis/1000UL) % numTestmodeNumbers;
-    io22d08.displayNumber(testmodeNumbers[i]);
-    io22d08.setColon(i%2 ? false: true);
-
-    // disable the relays for the 0'th display period
-    if (i)
-    {
-      io22d08.enableRelays();
-    }
-    else
-    {
-      io22d08.disableRelays();
-    }
+    io22d08.enableRelays();
+  }
+  else
+  {
+    io22d08.disableRelays();
   }
+  if (++i >= numTestmodeNumbers) i = 0;
+}
+
+
+// main tasks
 
+// unlike the display, the relay outputs are not multiplexed and don't need
+// continual refreshing; each step latches any relay changes along with the
+// next digit
+void refreshDisplay()
+{
+  io22d08.refreshStep();
+}
+
+void checkInputs()
+{
   for (auto & b : buttons) b.check();
   for (auto & i : inputs) i.check();
-  for (auto & t : relayTimers) t.tick();
+}
 
-  // unlike the display, the relay outputs are not multiplexed and don't need
-  // continual refreshing; however we want to show the display as well
-  io22d08.refreshDisplayAndRelays();
+// display the (active) timer that is expiring next (i.e. lowest delta)
+// - clear + redraw as a single update so the refresh never shows the
+//   intermediate blank display
+void updateDisplay()
+{
+  io22d08.beginDisplayUpdate();
+  io22d08.displayMessage(io22d08.MESSAGE_BLANK);  // clear the display
+  uint32_t mtr = relayTimers.nextTimeRemaining();
+  if (mtr != relayTimers.noDeadline)
+  {
+    io22d08.displayNumber(mtr/1000UL + 1); // +1: crude ceil()
+  }
+  io22d08.endDisplayUpdate();
 }
 
+// colon flash is asynchronous to timer and display updates
+void toggleColon()
+{
+  io22d08.toggleColon();
+}
 
-uint16_t _getMinTimeRemaining(uint16_t mtr, RelayTimer* timers, size_t nTimers)
+// process frequency switch trigger
+// - this tick could be executed every cycle but we don't need that fast a
+//   response
+// - freq switch state:
+//    - LOW: input signal period < low threshold (i.e. f = high)
+//    - HIGH: input signal period > high threshold (i.e. f = low)
+// - relay state (note; this is a binary mask, not a simple two-state var)
+//    - io22d08.RELAY_OFF: off
+//    - !io22d08.RELAY_OFF: on
+void frequencySwitch()
 {
-  for (size_t n = 0; n < nTimers; n++)
+  // report current frequency measurement, but only when it changes
+  static unsigned long previousPeriod;
+  long deltaPeriod;
+  unsigned long period = freqSwitch.getPeriod();
+  deltaPeriod = period - previousPeriod;
+  previousPeriod = period;
+  if (abs(deltaPeriod) > 100)
+  {
+    logger.record(F("f(Hz)="), (int32_t)(freqSwitch.getFrequency() + 0.5));
+  }
+
+  int freqSwitchState = freqSwitch.tick();
+  int relayState = io22d08.relayGet(io22d08.RELAY1);
+  // in this example, want the relay on at low frequencies, or when stopped
+  // if the relay is on and needs to be off, turn it off; ditto the inverse
+  switch (freqSwitchState)
   {
-    uint16_t tr = timers[n].getTimeRemaining();
-    if (tr < mtr) mtr = tr;
+    case freqSwitch.FS_STOPPED:
+      [[fallthrough]];
+    case freqSwitch.FS_LOW:
+      if (relayState == io22d08.RELAY_OFF)
+      {
+        // should be on but is off, turn on
+        io22d08.relaySet(io22d08.RELAY1, io22d08.RELAY_ON);
+      }
+      break;
+
+    case freqSwitch.FS_HIGH:
+      if (relayState != io22d08.RELAY_OFF)
+      {
+        // should be off but is on, turn off
+        io22d08.relaySet(io22d08.RELAY1, io22d08.RELAY_OFF);
+      }
+      break;
   }
-  return mtr;
 }
 
-void loop_main()
+// the lowest priority: events are only turned into log records while no
+// other task is about to be due
+// - commands and the 'p' report are blocking (EEPROM writes, Serial): they
+//   show up as this task's overruns, while the tasks above it only see the
+//   one late start
+void writeLog()
 {
-  static unsigned long previousMillis[] = {0, 0, 0};
-  const uint8_t PREVIOUS_MILLIS_COLON = 0;    // colon update
-  const uint8_t PREVIOUS_MILLIS_DISPLAY = 1;  // display update
-  const uint8_t PREVIOUS_MILLIS_FREQ = 2;     // freq switch update
-  unsigned long currentMillis;
-  currentMillis = millis();
-
-  // colon flash is asynchronous to timer and display updates
-  if (currentMillis - previousMillis[PREVIOUS_MILLIS_COLON] > 500)
+  if (scheduler.slack() > 1000) reportEvents();
+  logger.flush();
+  serialCommands();
+}
+
+// settings commands: "t <timer> <seconds>", "f <stopped> <lower> <upper>"
+void configCommand(char *line)
+{
+  char *p = line + 1;
+  uint32_t v[3];
+  uint8_t n = 0;
+  while (n < 3 && *p)
   {
-    previousMillis[PREVIOUS_MILLIS_COLON] = currentMillis;
-    io22d08.toggleColon();
+    char *end;
+    v[n] = strtoul(p, &end, 10);
+    if (end == p) break;
+    n++;
+    p = end;
   }
-
-  // update display
-  if (currentMillis - previousMillis[PREVIOUS_MILLIS_DISPLAY] > 250)
+  if (line[0] == 't' && n == 2 && v[0] < numRelayTimers)
   {
-    previousMillis[PREVIOUS_MILLIS_DISPLAY] = currentMillis;
-    // display the (active) timer that is expiring next (i.e. lowest delta)
-    io22d08.displayMessage(io22d08.MESSAGE_BLANK);  // clear the display
-    uint16_t mtr = UINT16_MAX;
-    mtr = _getMinTimeRemaining(mtr, relayTimers, numRelayTimers);
-    if (mtr != UINT16_MAX)
-    {
-      io22d08.displayNumber(mtr/1000UL + 1); // +1: crude ceil()
-    }
+    config.timers[v[0]].seconds = v[1];
+    config.applyTimers(relayTimers);
   }
+  else if (line[0] == 'f' && n == 3)
+  {
+    for (uint8_t i = 0; i < 3; i++) config.frequencyThresholds[i] = v[i];
+    freqSwitch.setThresholds(v[0], v[1], v[2]);
+  }
+  else
+  {
+    logger.record(F("?"), 0, F("CMD"));
+    return;
+  }
+  configStore.save(config);
+  logger.record(F("C"), configStore.sequence(), F("SAVED"));
+}
 
-  // process frequency switch trigger
-  if (currentMillis - previousMillis[PREVIOUS_MILLIS_FREQ] > 500)
+// a line at a time from Serial, without blocking
+void serialCommands()
+{
+  static char line[32];
+  static uint8_t length = 0;
+  while (Serial.available())
   {
-    previousMillis[PREVIOUS_MILLIS_FREQ] = currentMillis;
-
-    // - this tick could be executed every cycle but we don't need that fast a
-    //   response
-    // - freq switch state:
-    //    - LOW: input signal period < low threshold (i.e. f = high)
-    //    - HIGH: input signal period > high threshold (i.e. f = low)
-    // - relay state (note; this is a binary mask, not a simple two-state var)
-    //    - io22d08.RELAY_OFF: off
-    //    - !io22d08.RELAY_OFF: on
-
-    // report current frequency measurement, but only when it changes
-    static unsigned long previousPeriod;
-    long deltaPeriod;
-    deltaPeriod = freqSwitch.getPeriod() - previousPeriod;
-    previousPeriod = freqSwitch.getPeriod();
-    if (abs(deltaPeriod) > 100)
+    char c = Serial.read();
+    if (c == 'p' && !length)
     {
-      Serial.print(F("f="));
-      Serial.print(1e6/previousPeriod);
-      Serial.print(F("Hz("));
-      Serial.print(previousPeriod/1000.0);
-      Serial.println(F("ms)"));
+      logger.flushAll();  // the report is written directly, keep it in order
+      IO22_PROFILE_REPORT(Serial);
+      scheduler.report(Serial);
     }
-
-    int freqSwitchState = freqSwitch.tick();
-    int relayState = io22d08.relayGet(io22d08.RELAY1);
-    // in this example, want the relay on at low frequencies, or when stopped
-    // if the relay is on and needs to be off, turn it off; ditto the inverse
-    switch (freqSwitchState)
+    else if (c == '\n' || c == '\r')
     {
-      case freqSwitch.FS_STOPPED:
-        [[fallthrough]];
-      case freqSwitch.FS_LOW:
-        if (relayState == io22d08.RELAY_OFF)
-        {
-          // should be on but is off, turn on
-          Serial.println(F("F1<:ON"));
-          io22d08.relaySet(io22d08.RELAY1, io22d08.RELAY_ON);
-        }
-        break;
-
-      case freqSwitch.FS_HIGH:
-        if (relayState != io22d08.RELAY_OFF)
-        {
-          // should be off but is on, turn off
-          Serial.println(F("F1>:OFF"));
-          io22d08.relaySet(io22d08.RELAY1, io22d08.RELAY_OFF);
-        }
-        break;
+      line[length] = 0;
+      if (length) configCommand(line);
+      length = 0;
     }
+    else if (length < sizeof(line) - 1)
+      line[length++] = c;
   }
-
-  for (auto & b : buttons) b.check();
-  for (auto & i : inputs) i.check();
-  for (auto & t : relayTimers) t.tick();
-
-  io22d08.refreshDisplayAndRelays();
 }
 
 void loop() {
-  loop_fn();
-  digitalWrite(A4, digitalRead(A4)==HIGH?LOW:HIGH); // to measure loop time
+  scheduler.run();
+  IO22_PROFILE_LOOP();
 }
@@ -0,0 +1,146 @@
+#ifndef IO22_Host_Arduino_h
+
+#define IO22_Host_Arduino_h
+
+// a minimal Arduino core for building the library on a PC (see Makefile):
+// just the parts of the Arduino API the library's portable (non-AVR) paths
+// use, with the pins and time simulated by ArduinoHost.cpp
+// - no __AVR__: the library builds as it would for any other core, i.e. with
+//   the bit-bang transports and without the Timer2 refresh or the ISRs
+// - IO22Host: what the simulated core recorded, for the tests
+
+#include <stdint.h>
+#include <stddef.h>
+#include <stdlib.h>
+#include <string.h>
+
+typedef bool boolean;
+typedef uint8_t byte;
+
+#define HIGH 1
+#define LOW 0
+#define INPUT 0
+#define OUTPUT 1
+#define INPUT_PULLUP 2
+#define LSBFIRST 0
+#define MSBFIRST 1
+#define CHANGE 1
+#define FALLING 2
+#define RISING 3
+#define DEC 10
+#define HEX 16
+
+#ifndef F_CPU
+#define F_CPU 16000000UL
+#endif
+
+static const uint8_t A0 = 14, A1 = 15, A2 = 16, A3 = 17, A4 = 18, A5 = 19, A6 = 20, A7 = 21;
+static const uint8_t numHostPins = 22;
+
+#define lowByte(w) ((uint8_t)((w) & 0xFF))
+#define highByte(w) ((uint8_t)((w) >> 8))
+#define bitRead(value, bit) (((value) >> (bit)) & 0x01)
+#define _BV(bit) (1 << (bit))
+#define digitalPinToInterrupt(p) ((p) == 2 ? 0 : (p) == 3 ? 1 : -1)
+
+// flash is just memory
+#define PROGMEM
+#define PSTR(s) (s)
+#define pgm_read_byte(addr) (*(const uint8_t *)(addr))
+#define pgm_read_word(addr) (*(const uint16_t *)(addr))
+#define pgm_read_dword(addr) (*(const uint32_t *)(addr))
+#define pgm_read_ptr(addr) (*(const void *const *)(addr))
+#define memcpy_P memcpy
+#define strlen_P strlen
+#define PGM_P const char *
+
+class __FlashStringHelper;
+#define F(s) (reinterpret_cast<const __FlashStringHelper *>(s))
+
+void pinMode(uint8_t pin, uint8_t mode);
+void digitalWrite(uint8_t pin, uint8_t value);
+int digitalRead(uint8_t pin);
+void shiftOut(uint8_t dataPin, uint8_t clockPin, uint8_t bitOrder, uint8_t value);
+void attachInterrupt(uint8_t interruptNum, void (*isr)(), int mode);
+void detachInterrupt(uint8_t interruptNum);
+
+unsigned long millis();
+unsigned long micros();
+void delay(unsigned long ms);
+void delayMicroseconds(unsigned int us);
+
+void noInterrupts();
+void interrupts();
+
+class Print
+{
+  public:
+    virtual ~Print() {}
+    virtual size_t write(uint8_t c) = 0;
+    virtual int availableForWrite() { return 0; }
+    size_t write(const uint8_t *buffer, size_t size);
+    size_t write(const char *s) { return write((const uint8_t *)s, strlen(s)); }
+
+    size_t print(const __FlashStringHelper *s) { return write((const char *)s); }
+    size_t print(const char *s) { return write(s); }
+    size_t print(char c) { return write((uint8_t)c); }
+    size_t print(unsigned char n, int base = DEC) { return print((unsigned long)n, base); }
+    size_t print(int n, int base = DEC) { return print((long)n, base); }
+    size_t print(unsigned int n, int base = DEC) { return print((unsigned long)n, base); }
+    size_t print(long n, int base = DEC);
+    size_t print(unsigned long n, int base = DEC);
+    size_t print(double n, int digits = 2);
+
+    size_t println() { return write("\r\n"); }
+    template <class T> size_t println(T value) { size_t n = print(value); return n + println(); }
+    template <class T> size_t println(T value, int format) { size_t n = print(value, format); return n + println(); }
+};
+
+class Stream : public Print
+{
+  public:
+    virtual int available() = 0;
+    virtual int read() = 0;
+    virtual int peek() = 0;
+};
+
+// Serial: written to stdout, nothing to read
+class HardwareSerial : public Stream
+{
+  public:
+    void begin(unsigned long) {}
+    void flush() {}
+    size_t write(uint8_t c) override;
+    int availableForWrite() override { return 64; }
+    int available() override { return 0; }
+    int read() override { return -1; }
+    int peek() override { return -1; }
+    operator bool() { return true; }
+    using Print::write;
+};
+
+extern HardwareSerial Serial;
+
+namespace IO22Host
+{
+  // the bytes passed to shiftOut() since the last reset (up to capacity),
+  // and the latch pin's rising edges
+  static const uint16_t capacity = 256;
+  void reset();
+  const uint8_t *shifted();
+  uint16_t shiftedCount();
+  uint32_t risingEdges(uint8_t pin);
+
+  // the simulated input levels (default HIGH, i.e. inactive)
+  void setPin(uint8_t pin, uint8_t value);
+  uint8_t pinLevel(uint8_t pin);
+
+  // false between noInterrupts() and interrupts()
+  bool interruptsEnabled();
+
+  // simulated time: moved on by delay()/delayMicroseconds(), by 4us per
+  // micros()/millis() call (so busy waits come to an end) and by this
+  void advanceMicros(unsigned long us);
+}
+
+#endif
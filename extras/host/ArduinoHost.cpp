@@ -0,0 +1,158 @@
+/*
+  the simulated Arduino core for the host build (see Arduino.h)
+
+  - pins: each has a level; digitalWrite() sets it, digitalRead() reads it
+    (the inputs idle HIGH, as the board's pull-ups hold them), and the rising
+    edges are counted (e.g. the shift register latch)
+  - shiftOut() records the bytes, so a bit-bang transport's output can be
+    checked without a recording transport in between
+  - time is simulated, see IO22Host::advanceMicros()
+*/
+
+#include <stdio.h>
+#include "Arduino.h"
+
+HardwareSerial Serial;
+
+static uint8_t _levels[numHostPins];
+static uint32_t _rising[numHostPins];
+static uint8_t _shifted[IO22Host::capacity];
+static uint16_t _shiftedCount = 0;
+static unsigned long _micros = 0;
+static bool _interruptsEnabled = true;
+static bool _levelsSet = false;
+
+static void _initLevels()
+{
+  if (_levelsSet) return;
+  for (uint8_t p = 0; p < numHostPins; p++) _levels[p] = HIGH;
+  _levelsSet = true;
+}
+
+void pinMode(uint8_t, uint8_t)
+{
+}
+
+void digitalWrite(uint8_t pin, uint8_t value)
+{
+  if (pin >= numHostPins) return;
+  _initLevels();
+  value = value ? HIGH : LOW;
+  if (value && !_levels[pin]) _rising[pin]++;
+  _levels[pin] = value;
+}
+
+int digitalRead(uint8_t pin)
+{
+  _initLevels();
+  return pin < numHostPins ? _levels[pin] : LOW;
+}
+
+void shiftOut(uint8_t dataPin, uint8_t clockPin, uint8_t bitOrder, uint8_t value)
+{
+  for (uint8_t i = 0; i < 8; i++)
+  {
+    uint8_t bit = bitOrder == MSBFIRST ? 7 - i : i;
+    digitalWrite(dataPin, (value >> bit) & 1);
+    digitalWrite(clockPin, HIGH);
+    digitalWrite(clockPin, LOW);
+  }
+  if (_shiftedCount < IO22Host::capacity) _shifted[_shiftedCount++] = value;
+}
+
+void attachInterrupt(uint8_t, void (*)(), int)
+{
+}
+
+void detachInterrupt(uint8_t)
+{
+}
+
+unsigned long micros()
+{
+  _micros += 4;
+  return _micros;
+}
+
+unsigned long millis()
+{
+  return micros() / 1000;
+}
+
+void delay(unsigned long ms)
+{
+  _micros += ms * 1000;
+}
+
+void delayMicroseconds(unsigned int us)
+{
+  _micros += us;
+}
+
+void noInterrupts()
+{
+  _interruptsEnabled = false;
+}
+
+void interrupts()
+{
+  _interruptsEnabled = true;
+}
+
+size_t Print::write(const uint8_t *buffer, size_t size)
+{
+  size_t n = 0;
+  while (size--) n += write(*buffer++);
+  return n;
+}
+
+size_t Print::print(long n, int base)
+{
+  if (n < 0 && base == DEC) return print('-') + print((unsigned long)-n, base);
+  return print((unsigned long)n, base);
+}
+
+size_t Print::print(unsigned long n, int base)
+{
+  char buffer[40];
+  snprintf(buffer, sizeof(buffer), base == HEX ? "%lX" : "%lu", n);
+  return write(buffer);
+}
+
+size_t Print::print(double n, int digits)
+{
+  char buffer[40];
+  snprintf(buffer, sizeof(buffer), "%.*f", digits, n);
+  return write(buffer);
+}
+
+size_t HardwareSerial::write(uint8_t c)
+{
+  if (c != '\r') putchar(c);
+  return 1;
+}
+
+namespace IO22Host
+{
+  void reset()
+  {
+    _shiftedCount = 0;
+    for (uint8_t p = 0; p < numHostPins; p++) _rising[p] = 0;
+  }
+
+  const uint8_t *shifted() { return _shifted; }
+  uint16_t shiftedCount() { return _shiftedCount; }
+  uint32_t risingEdges(uint8_t pin) { return pin < numHostPins ? _rising[pin] : 0; }
+
+  void setPin(uint8_t pin, uint8_t value)
+  {
+    _initLevels();
+    if (pin < numHostPins) _levels[pin] = value ? HIGH : LOW;
+  }
+
+  uint8_t pinLevel(uint8_t pin) { return digitalRead(pin); }
+
+  bool interruptsEnabled() { return _interruptsEnabled; }
+
+  void advanceMicros(unsigned long us) { _micros += us; }
+}
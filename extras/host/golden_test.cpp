@@ -0,0 +1,57 @@
+/*
+  the benchmark's golden frame check (examples/IO22D08Benchmark), on the host
+
+  - the same cases and comparison (GoldenFrames.h), through IO22RecordingShift
+    on its own and wrapped around the bit-bang transport
+  - the bit-bang board's shiftOut() output (as the simulated core saw it) has
+    to match what its recorder saw, i.e. the transport passes the frames on
+    unchanged
+*/
+
+#include <stdio.h>
+#include "Arduino.h"
+#include "IO22_IO_Board.h"
+#include "../../examples/IO22D08Benchmark/GoldenFrames.h"
+
+typedef IO22RecordingShift<> Recorder;
+typedef IO22RecordingShift<IO22BitBangShift> BitBangRecorder;
+
+static int _failures = 0;
+
+static void check(const char *name, uint16_t failures)
+{
+  printf("%s: %s\n", name, failures ? "FAIL" : "pass");
+  if (failures) _failures++;
+}
+
+// the bytes the transport shifted out match the recorder's, case by case
+static uint16_t checkBitBangOutput(IO22D08Board<BitBangRecorder> &board)
+{
+  uint16_t failures = 0;
+  for (uint8_t c = 0; c < numGoldenCases; c++)
+  {
+    board.displayNumber(c * 1111U);
+    board.relaySet(IO22D08Base::RELAYS_ALL, c * 37);
+    BitBangRecorder::reset();
+    IO22Host::reset();
+    board.refreshDisplayAndRelays();
+    if (IO22Host::shiftedCount() != BitBangRecorder::recorded()
+      || memcmp(IO22Host::shifted(), BitBangRecorder::bytes(), BitBangRecorder::recorded())
+      || IO22Host::risingEdges(IO22BitBangShift::latchPin) != BitBangRecorder::frames())
+      failures++;
+  }
+  return failures;
+}
+
+int main()
+{
+  IO22D08Board<Recorder> recordingBoard;
+  IO22D08Board<BitBangRecorder> bitBangBoard;
+  recordingBoard.begin();
+  bitBangBoard.begin();
+
+  check("golden (no transport)", checkGolden<Recorder>(recordingBoard, Serial));
+  check("golden (bit bang)", checkGolden<BitBangRecorder>(bitBangBoard, Serial));
+  check("bit bang output", checkBitBangOutput(bitBangBoard));
+  return _failures ? 1 : 0;
+}
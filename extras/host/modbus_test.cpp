@@ -0,0 +1,94 @@
+/*
+  IO22ModbusRTU request handling on the host
+
+  - requests are put in the frame buffer as the RX ISR would leave them and
+    served by poll(); on the host the response stays in the buffer
+  - the address ranges near 0xFFFF: on the AVR start + count is a 16 bit int
+    and used to wrap, letting a write to coil 0xFFFF switch RELAY1 and a read
+    shift by 0xFFFF bits
+*/
+
+#include <stdio.h>
+#include "Arduino.h"
+#include "IO22_IO_Board.h"
+#include "IO22_ModbusRTU.h"
+
+class ModbusHarness : public IO22ModbusRTU
+{
+  public:
+    ModbusHarness(IO22D08Base &board) : IO22ModbusRTU(board) {}
+
+    // serve a request (without its CRC); returns the response's function code
+    uint8_t request(const uint8_t *frame, uint8_t size)
+    {
+      memcpy(_buffer, frame, size);
+      uint16_t crc = IO22Crc16::update(IO22Crc16::initial, frame, size);
+      _buffer[size] = lowByte(crc);
+      _buffer[size + 1] = highByte(crc);
+      _length = size + 2;
+      _crc = 0;
+      _frameError = false;
+      _state = STATE_FRAME;
+      poll();
+      return _buffer[1];
+    }
+    uint8_t response(uint8_t i) { return _buffer[i]; }
+};
+
+static IO22D08Board<IO22NullShift> board;
+static ModbusHarness modbus(board);
+static int _failures = 0;
+
+static void check(const char *name, bool pass)
+{
+  printf("%s: %s\n", name, pass ? "pass" : "FAIL");
+  if (!pass) _failures++;
+}
+
+// an exception response with the given code, e.g. 2: illegal data address
+static bool isException(uint8_t function, uint8_t code)
+{
+  return modbus.response(1) == (function | 0x80) && modbus.response(2) == code;
+}
+
+int main()
+{
+  board.begin();
+  modbus.begin(19200, 1);
+
+  const uint8_t writeWrapped[] = {1, 0x0F, 0xFF, 0xFF, 0x00, 0x02, 0x01, 0x03};
+  modbus.request(writeWrapped, sizeof(writeWrapped));
+  check("write coils 0xFFFF+2", isException(0x0F, 2) && board.relayGet(IO22D08Base::RELAYS_ALL) == 0);
+
+  const uint8_t writePastEnd[] = {1, 0x0F, 0x00, 0x07, 0x00, 0x02, 0x01, 0x03};
+  modbus.request(writePastEnd, sizeof(writePastEnd));
+  check("write coils 7+2", isException(0x0F, 2) && board.relayGet(IO22D08Base::RELAYS_ALL) == 0);
+
+  const uint8_t readCoilsWrapped[] = {1, 0x01, 0xFF, 0xFF, 0x00, 0x01};
+  modbus.request(readCoilsWrapped, sizeof(readCoilsWrapped));
+  check("read coils 0xFFFF+1", isException(0x01, 2));
+
+  const uint8_t readInputsWrapped[] = {1, 0x02, 0xFF, 0xFF, 0x00, 0x01};
+  modbus.request(readInputsWrapped, sizeof(readInputsWrapped));
+  check("read inputs 0xFFFF+1", isException(0x02, 2));
+
+  const uint8_t readCoilsAtEnd[] = {1, 0x01, 0x00, 0x08, 0x00, 0x01};
+  modbus.request(readCoilsAtEnd, sizeof(readCoilsAtEnd));
+  check("read coils 8+1", isException(0x01, 2));
+
+  // coils 1 and 2 (RELAY1, RELAY2), then read back all 8
+  const uint8_t writeCoils[] = {1, 0x0F, 0x00, 0x00, 0x00, 0x02, 0x01, 0x03};
+  modbus.request(writeCoils, sizeof(writeCoils));
+  check("write coils 0+2", modbus.response(1) == 0x0F
+    && board.relayGet(IO22D08Base::RELAYS_ALL) == (IO22D08Base::RELAY1 | IO22D08Base::RELAY2));
+
+  const uint8_t readCoils[] = {1, 0x01, 0x00, 0x00, 0x00, 0x08};
+  modbus.request(readCoils, sizeof(readCoils));
+  check("read coils 0+8", modbus.response(1) == 0x01 && modbus.response(2) == 1 && modbus.response(3) == 0x03);
+
+  const uint8_t readLastCoil[] = {1, 0x01, 0x00, 0x07, 0x00, 0x01};
+  modbus.request(readLastCoil, sizeof(readLastCoil));
+  check("read coils 7+1", modbus.response(1) == 0x01 && modbus.response(3) == 0x00);
+
+  return _failures ? 1 : 0;
+}
@@ -0,0 +1,38 @@
+/*
+  IO22_Platform.h on the host: the portable IO22InterruptLock nests (only the
+  outermost lock re-enables interrupts), and the CRC matches the Modbus check
+  value
+*/
+
+#include <stdio.h>
+#include "Arduino.h"
+#include "IO22_Platform.h"
+
+static int _failures = 0;
+
+static void check(const char *name, bool pass)
+{
+  printf("%s: %s\n", name, pass ? "pass" : "FAIL");
+  if (!pass) _failures++;
+}
+
+int main()
+{
+  bool outer, inner, after;
+  {
+    IO22InterruptLock lock;
+    outer = IO22Host::interruptsEnabled();
+    {
+      IO22InterruptLock nested;
+      inner = IO22Host::interruptsEnabled();
+    }
+    after = IO22Host::interruptsEnabled();
+  }
+  check("lock disables interrupts", !outer && !inner);
+  check("nested lock keeps them disabled", !after);
+  check("outermost lock re-enables them", IO22Host::interruptsEnabled());
+
+  // CRC-16/MODBUS check value: "123456789" -> 0x4B37
+  check("crc16", IO22Crc16::update(IO22Crc16::initial, "123456789", 9) == 0x4B37);
+  return _failures ? 1 : 0;
+}